@@ -9,10 +9,13 @@
 #import "TableViewController.h"
 #import "SWRevealTableViewCell.h"
 
-@interface TableViewController ()<SWRevealTableViewCellDelegate,SWRevealTableViewCellDataSource,UIActionSheetDelegate>
+@interface TableViewController ()<SWRevealTableViewCellDelegate,SWRevealTableViewCellDataSource>
 {
-    NSIndexPath *_revealingCellIndexPath;
     NSInteger _sectionTitleRowCount;
+    SWRevealTableViewCellCoordinator *_revealCoordinator;
+    SWCellButtonItemMenu *_deleteMenu;
+    SWCellButtonItemMenu *_renameMenu;
+    SWCellButtonItemMenu *_moreMenu;
 }
 
 @end
@@ -63,6 +66,9 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
     [self.navigationItem setRightBarButtonItem:buttonItemAdd];
     
     _sectionTitleRowCount = 4;
+    
+    // The coordinator keeps a single revealed cell and closes it on scroll
+    _revealCoordinator = [[SWRevealTableViewCellCoordinator alloc] initWithTableView:self.tableView];
 }
 
 
@@ -102,6 +108,7 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
 
     cell.delegate = self;
     cell.dataSource = self;
+    [_revealCoordinator configureCell:cell forRowAtIndexPath:indexPath];
     
     // Configure the cell...
     cell.detailTextLabel.text = @"Detail text";
@@ -182,6 +189,9 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
 {
     // customize here the cell object before it is displayed.
     
+    // get button items ready before the user swipes the cell
+    [(SWRevealTableViewCell*)cell prepareButtonItemsIfNeeded];
+    
 //    [cell setBackgroundColor:[UIColor colorWithWhite:1.0 alpha:0.5]];
 //    UIImageView *imageView = [[UIImageView alloc] initWithImage:[UIImage imageNamed:@"beach-wallpaper-in-hd-166.jpg"]];
 //    imageView.contentMode = UIViewContentModeScaleAspectFill;
@@ -243,16 +253,7 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
 
 - (void)revealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell willMoveToPosition:(SWCellRevealPosition)position
 {
-    if ( position == SWCellRevealPositionCenter )
-        return;
-    
-    for ( SWRevealTableViewCell *cell in [self.tableView visibleCells] )
-    {
-        if ( cell == revealTableViewCell )
-            continue;
-        
-        [cell setRevealPosition:SWCellRevealPositionCenter animated:YES];
-    }
+    // Closing other cells is taken care by the reveal coordinator
 }
 
 
@@ -298,8 +299,7 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
     {
         SWCellButtonItem *item1 = [SWCellButtonItem itemWithTitle:@"Delete" handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell)
         {
-            _revealingCellIndexPath = [self.tableView indexPathForCell:cell];
-            [self presentDeleteActionSheetForItem:item];
+            [self presentDeleteMenuForItem:item];
         }];
     
         item1.backgroundColor = [UIColor redColor];
@@ -309,8 +309,7 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
     
         SWCellButtonItem *item2 = [SWCellButtonItem itemWithTitle:@"Rename" handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell)
         {
-            _revealingCellIndexPath = [self.tableView indexPathForCell:cell];
-            [self presentRenameActionSheetForItem:item];
+            [self presentRenameMenuForItem:item];
         }];
 
         item2.backgroundColor = [UIColor darkGrayColor];
@@ -319,8 +318,7 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
     
         SWCellButtonItem *item3 = [SWCellButtonItem itemWithTitle:@"More" handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell)
         {
-            _revealingCellIndexPath = [self.tableView indexPathForCell:cell];
-            [self presentMoreActionSheetForItem:item];
+            [self presentMoreMenuForItem:item];
         }];
     
         item3.backgroundColor = [UIColor lightGrayColor];
@@ -339,6 +337,7 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
         item1.backgroundColor = [UIColor orangeColor];
         item1.tintColor = [UIColor whiteColor];
         item1.width = 50;
+        item1.renderingMode = SWCellButtonItemRenderingModeLayer;
     
     
         SWCellButtonItem *item2 = [SWCellButtonItem itemWithImage:[UIImage imageNamed:@"heart.png"] handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell)
@@ -349,6 +348,7 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
         item2.backgroundColor = [UIColor darkGrayColor];
         item2.tintColor = [UIColor redColor];
         item2.width = 50;
+        item2.renderingMode = SWCellButtonItemRenderingModeLayer;
     
         SWCellButtonItem *item3 = [SWCellButtonItem itemWithImage:[UIImage imageNamed:@"airplane.png"] handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell)
         {
@@ -357,6 +357,7 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
     
         item3.backgroundColor = [UIColor lightGrayColor];
         item3.width = 50;
+        item3.renderingMode = SWCellButtonItemRenderingModeLayer;
     
         items = @[item1,item2,item3];
     }
@@ -376,39 +377,57 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
 }
 
 
-#pragma mark - UIActionSheet
+#pragma mark - Menus
 
 
-- (void)presentDeleteActionSheetForItem:(SWCellButtonItem*)cellItem
+- (void)presentDeleteMenuForItem:(SWCellButtonItem*)cellItem
 {
-    UIActionSheet *actSheet = [[UIActionSheet alloc] initWithTitle:@"Delete Actions"
-                delegate:self
-                cancelButtonTitle:@"Cancel"
-                destructiveButtonTitle:@"Delete Now"
-                otherButtonTitles:nil ];
-
-    [actSheet setTag:0];
-    [actSheet showFromCellButtonItem:cellItem animated:YES];
+    if ( _deleteMenu == nil )
+    {
+        __weak TableViewController *weakSelf = self;
+        _deleteMenu = [SWCellButtonItemMenu menuWithTitle:@"Delete Actions" message:nil];
+        
+        [_deleteMenu addActionWithTitle:@"Delete Now" style:UIAlertActionStyleDestructive handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell)
+        {
+            [weakSelf _performDeleteActionForCell:cell];
+        }];
+        
+        [_deleteMenu addActionWithTitle:@"Cancel" style:UIAlertActionStyleCancel handler:nil];
+    }
+
+    [_deleteMenu presentFromCellButtonItem:cellItem inViewController:self animated:YES];
 }
 
 
-- (void)_performDeleteAction
+- (void)_performDeleteActionForCell:(SWRevealTableViewCell*)cell
 {
+    NSIndexPath *indexPath = [self.tableView indexPathForCell:cell];
+    if ( indexPath == nil )
+        return;
+
     _sectionTitleRowCount -= 1;
-    [self.tableView deleteRowsAtIndexPaths:@[_revealingCellIndexPath] withRowAnimation:UITableViewRowAnimationFade];
+    [_revealCoordinator closeRevealedCellAnimated:NO];
+    [self.tableView deleteRowsAtIndexPaths:@[indexPath] withRowAnimation:UITableViewRowAnimationFade];
 }
 
 
-- (void)presentRenameActionSheetForItem:(SWCellButtonItem*)cellItem
+- (void)presentRenameMenuForItem:(SWCellButtonItem*)cellItem
 {
-    UIActionSheet *actSheet = [[UIActionSheet alloc] initWithTitle:@"More Actions"
-                delegate:self
-                cancelButtonTitle:@"Cancel"
-                destructiveButtonTitle:nil
-                otherButtonTitles:@"Action Rename", nil ];
-
-    [actSheet setTag:1];
-    [actSheet showFromCellButtonItem:cellItem animated:YES];
+    if ( _renameMenu == nil )
+    {
+        __weak TableViewController *weakSelf = self;
+        _renameMenu = [SWCellButtonItemMenu menuWithTitle:@"More Actions" message:nil];
+        
+        [_renameMenu addActionWithTitle:@"Action Rename" style:UIAlertActionStyleDefault handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell)
+        {
+            [weakSelf _performRenameAction];
+            [cell setRevealPosition:SWCellRevealPositionCenter animated:YES];
+        }];
+        
+        [_renameMenu addActionWithTitle:@"Cancel" style:UIAlertActionStyleCancel handler:nil];
+    }
+
+    [_renameMenu presentFromCellButtonItem:cellItem inViewController:self animated:YES];
 }
 
 
@@ -418,16 +437,27 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
 }
 
 
-- (void)presentMoreActionSheetForItem:(SWCellButtonItem*)cellItem
+- (void)presentMoreMenuForItem:(SWCellButtonItem*)cellItem
 {
-    UIActionSheet *actSheet = [[UIActionSheet alloc] initWithTitle:@"More Actions"
-                delegate:self
-                cancelButtonTitle:@"Cancel"
-                destructiveButtonTitle:nil
-                otherButtonTitles:@"Action One", @"Action Two", @"Action Three", nil ];
-
-    [actSheet setTag:2];
-    [actSheet showFromCellButtonItem:cellItem animated:YES];
+    if ( _moreMenu == nil )
+    {
+        __weak TableViewController *weakSelf = self;
+        _moreMenu = [SWCellButtonItemMenu menuWithTitle:@"More Actions" message:nil];
+        
+        NSArray *titles = @[@"Action One", @"Action Two", @"Action Three"];
+        for ( NSInteger index=0 ; index<titles.count ; index++ )
+        {
+            [_moreMenu addActionWithTitle:titles[index] style:UIAlertActionStyleDefault handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell)
+            {
+                [weakSelf _performMoreActionAtIndex:index];
+                [cell setRevealPosition:SWCellRevealPositionCenter animated:YES];
+            }];
+        }
+        
+        [_moreMenu addActionWithTitle:@"Cancel" style:UIAlertActionStyleCancel handler:nil];
+    }
+
+    [_moreMenu presentFromCellButtonItem:cellItem inViewController:self animated:YES];
 }
 
 
@@ -453,40 +483,4 @@ static NSString *RevealCellReuseIdentifier = @"RevealCellReuseIdentifier";
 }
 
 
-// UIActionSheet delegate
-- (void)actionSheet:(UIActionSheet *)actionSheet clickedButtonAtIndex:(NSInteger)buttonIndex
-{
-    //NSLog( @"clickedButtonAtIndex: %d", buttonIndex );
-    
-    if ( buttonIndex == [actionSheet cancelButtonIndex] )
-    {
-        NSLog( @"Cancel");
-        return;
-    }
-    
-    NSInteger index = buttonIndex - actionSheet.firstOtherButtonIndex;
-    
-    switch ( actionSheet.tag )
-    {
-        case 0:  // delete
-            [self _performDeleteAction];
-            break;
-            
-        case 1:  // rename
-            [self _performRenameAction];
-            break;
-            
-        case 2:  // more
-            [self _performMoreActionAtIndex:index];
-            break;
-
-        default:
-            break;
-    }
-    
-    SWRevealTableViewCell *cell = (id)[self.tableView cellForRowAtIndexPath:_revealingCellIndexPath];
-    [cell setRevealPosition:SWCellRevealPositionCenter animated:YES];
-}
-
-
 @end
@@ -8,27 +8,853 @@
 
 #import <XCTest/XCTest.h>
 
-@interface RevealTableViewCellExampleTests : XCTestCase
+#import "SWRevealTableViewCell.h"
+
+
+#pragma mark - Private methods
+
+// Gesture handlers are driven directly, so benchmarks do not depend on touch delivery
+
+@interface SWRevealTableViewCell(Benchmarks)
+- (void)_handleRevealGestureStateBeganWithRecognizer:(UIPanGestureRecognizer *)recognizer;
+- (void)_handleRevealGestureStateChangedWithRecognizer:(UIPanGestureRecognizer *)recognizer;
+- (void)_handleRevealGestureStateEndedWithRecognizer:(UIPanGestureRecognizer *)recognizer;
+- (void)_handleRevealGestureStateCancelledWithRecognizer:(UIPanGestureRecognizer *)recognizer;
+- (void)_panDisplayLinkFired:(CADisplayLink*)displayLink;
+@end
+
+
+#pragma mark - SyntheticPanGestureRecognizer
+
+// A pan gesture recognizer reporting whatever translation and velocity we set on it
+
+@interface SyntheticPanGestureRecognizer : UIPanGestureRecognizer
+@property (nonatomic) CGFloat syntheticTranslation;
+@property (nonatomic) CGFloat syntheticVelocity;
+@end
+
+
+@implementation SyntheticPanGestureRecognizer
+
+- (CGPoint)translationInView:(UIView *)view
+{
+    return CGPointMake(_syntheticTranslation, 0);
+}
+
+
+- (CGPoint)velocityInView:(UIView *)view
+{
+    return CGPointMake(_syntheticVelocity, 0);
+}
+
+@end
+
+
+#pragma mark - GestureTrace
+
+// A pan gesture as a sequence of touch samples, either recorded on a device or synthesized. Times are in seconds
+// from the first sample, translations and velocities are horizontal, in points and points per second
+
+typedef struct
+{
+    NSTimeInterval time;
+    CGFloat translation;
+    CGFloat velocity;
+} GestureTraceSample;
+
+
+@interface GestureTrace : NSObject
++ (instancetype)traceWithPropertyList:(NSArray*)propertyList;
++ (instancetype)traceWithDuration:(NSTimeInterval)duration sampleRate:(double)sampleRate translation:(CGFloat(^)(CGFloat progress))translation;
+- (void)addSampleAtTime:(NSTimeInterval)time translation:(CGFloat)translation velocity:(CGFloat)velocity;
+@property (nonatomic, readonly) NSInteger sampleCount;
+@property (nonatomic, readonly) GestureTraceSample *samples;
+@property (nonatomic) BOOL cancelled;       // the gesture ends cancelled rather than ended
+@end
+
+
+@implementation GestureTrace
+{
+    NSMutableData *_data;
+}
+
+// Recorded traces are property lists, an array of @[time, translation, velocity] arrays
++ (instancetype)traceWithPropertyList:(NSArray*)propertyList
+{
+    GestureTrace *trace = [[GestureTrace alloc] init];
+    for ( NSArray *sample in propertyList )
+    {
+        [trace addSampleAtTime:[sample[0] doubleValue] translation:[sample[1] doubleValue] velocity:[sample[2] doubleValue]];
+    }
+    return trace;
+}
+
+
+// Synthesized traces sample a translation function at the given rate, velocities are derived from consecutive samples
++ (instancetype)traceWithDuration:(NSTimeInterval)duration sampleRate:(double)sampleRate translation:(CGFloat(^)(CGFloat progress))translation
+{
+    GestureTrace *trace = [[GestureTrace alloc] init];
+    NSInteger count = MAX(2, (NSInteger)(duration*sampleRate)+1);
+    
+    CGFloat previous = translation(0);
+    for ( NSInteger i=0 ; i<count ; i++ )
+    {
+        NSTimeInterval time = i/sampleRate;
+        CGFloat value = translation((CGFloat)i/(count-1));
+        [trace addSampleAtTime:time translation:value velocity:i>0 ? (value-previous)*sampleRate : 0];
+        previous = value;
+    }
+    return trace;
+}
+
+
+- (id)init
+{
+    self = [super init];
+    if ( self )
+    {
+        _data = [NSMutableData data];
+    }
+    return self;
+}
+
+
+- (void)addSampleAtTime:(NSTimeInterval)time translation:(CGFloat)translation velocity:(CGFloat)velocity
+{
+    GestureTraceSample sample = { time, translation, velocity };
+    [_data appendBytes:&sample length:sizeof(sample)];
+}
+
+
+- (NSInteger)sampleCount
+{
+    return _data.length/sizeof(GestureTraceSample);
+}
+
+
+- (GestureTraceSample*)samples
+{
+    return (GestureTraceSample*)_data.mutableBytes;
+}
+
+@end
+
+
+#pragma mark - GestureReplay
+
+// Feeds a trace to the cell gesture handlers, in the same order a live recognizer would, with no touch delivery
+// and no run loop involved. Display frames are simulated at a fixed rate from the sample times, so coalesced updates
+// are applied on the same frames each time. The cost of each frame is the time spent in the handlers during it
+
+@interface GestureReplay : NSObject
++ (instancetype)replayTrace:(GestureTrace*)trace onCell:(SWRevealTableViewCell*)cell
+    recognizer:(SyntheticPanGestureRecognizer*)recognizer frameInterval:(NSTimeInterval)frameInterval;
+@property (nonatomic, readonly) NSArray *frameDurations;     // NSNumbers, one per frame that received samples
+@property (nonatomic, readonly) NSTimeInterval worstFrameDuration;
+@property (nonatomic, readonly) NSTimeInterval totalDuration;
+@end
+
+
+@implementation GestureReplay
+
++ (instancetype)replayTrace:(GestureTrace*)trace onCell:(SWRevealTableViewCell*)cell
+    recognizer:(SyntheticPanGestureRecognizer*)recognizer frameInterval:(NSTimeInterval)frameInterval
+{
+    GestureReplay *replay = [[GestureReplay alloc] init];
+    NSMutableArray *frameDurations = [NSMutableArray array];
+    
+    NSInteger count = trace.sampleCount;
+    GestureTraceSample *samples = trace.samples;
+    
+    recognizer.syntheticTranslation = samples[0].translation;
+    recognizer.syntheticVelocity = samples[0].velocity;
+    [cell _handleRevealGestureStateBeganWithRecognizer:recognizer];
+    
+    NSInteger frame = 0;
+    NSTimeInterval frameDuration = 0;
+    BOOL frameHasSamples = NO;
+    
+    for ( NSInteger i=1 ; i<count ; i++ )
+    {
+        // close the frame when a sample falls past it, the display link applies the pending update at the end of each frame
+        NSInteger sampleFrame = (NSInteger)floor(samples[i].time/frameInterval);
+        if ( sampleFrame > frame )
+        {
+            if ( frameHasSamples )
+            {
+                CFTimeInterval startTime = CACurrentMediaTime();
+                [cell _panDisplayLinkFired:nil];
+                frameDuration += CACurrentMediaTime()-startTime;
+                [frameDurations addObject:@(frameDuration)];
+            }
+            frame = sampleFrame;
+            frameDuration = 0;
+            frameHasSamples = NO;
+        }
+    
+        recognizer.syntheticTranslation = samples[i].translation;
+        recognizer.syntheticVelocity = samples[i].velocity;
+        
+        CFTimeInterval startTime = CACurrentMediaTime();
+        [cell _handleRevealGestureStateChangedWithRecognizer:recognizer];
+        frameDuration += CACurrentMediaTime()-startTime;
+        frameHasSamples = YES;
+    }
+    
+    // ending the gesture applies any pending update, so it counts as the last frame
+    CFTimeInterval startTime = CACurrentMediaTime();
+    if ( trace.cancelled ) [cell _handleRevealGestureStateCancelledWithRecognizer:recognizer];
+    else [cell _handleRevealGestureStateEndedWithRecognizer:recognizer];
+    frameDuration += CACurrentMediaTime()-startTime;
+    [frameDurations addObject:@(frameDuration)];
+    
+    replay->_frameDurations = frameDurations;
+    for ( NSNumber *duration in frameDurations )
+    {
+        replay->_worstFrameDuration = MAX(replay->_worstFrameDuration, duration.doubleValue);
+        replay->_totalDuration += duration.doubleValue;
+    }
+    return replay;
+}
+
+
+- (NSString*)description
+{
+    NSMutableString *frames = [NSMutableString string];
+    for ( NSNumber *duration in _frameDurations )
+        [frames appendFormat:@" %.2f", duration.doubleValue*1000];
+    
+    return [NSString stringWithFormat:@"<%@: %p; total = %.4f; worstFrame = %.4f; frames(ms) =%@>",
+        NSStringFromClass([self class]), self, _totalDuration, _worstFrameDuration, frames];
+}
 
 @end
 
+
+#pragma mark - RevealTableViewCellExampleTests
+
+static const NSInteger BenchmarkIterations = 100;
+static const NSInteger BenchmarkPanSteps = 60;
+static const NSInteger BenchmarkRowCount = 10000;
+static const NSTimeInterval BenchmarkFrameInterval = 1.0/60;
+
+static NSString *BenchmarkCellReuseIdentifier = @"BenchmarkCellReuseIdentifier";
+
+
+@interface RevealTableViewCellExampleTests : XCTestCase<SWRevealTableViewCellDataSource,SWRevealTableViewCellDelegate,SWRevealTableViewCellMetricsDelegate,UITableViewDataSource>
+{
+    UIWindow *_window;
+    NSInteger _itemCount;
+    BOOL _automaticWidths;
+    BOOL _iconItems;
+    UIImage *_iconImage;
+    SWRevealTableViewCellCoordinator *_coordinator;
+    SWRevealGestureMetrics *_gestureMetrics;
+    NSMutableArray *_movedPositions;
+}
+
+@end
+
+
 @implementation RevealTableViewCellExampleTests
 
 - (void)setUp
 {
     [super setUp];
-    // Put setup code here. This method is called before the invocation of each test method in the class.
+
+    _window = [[UIWindow alloc] initWithFrame:CGRectMake(0, 0, 320, 480)];
+    [_window setHidden:NO];
+    _itemCount = 3;
 }
 
+
 - (void)tearDown
 {
-    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    [_window setHidden:YES];
+    _window = nil;
+    _coordinator = nil;
+
+    [SWRevealTableViewCell purgeButtonItemsCache];
     [super tearDown];
 }
 
-- (void)testExample
+
+#pragma mark - Helpers
+
+// Measures CPU time, memory and wall clock time where XCTest supports metrics (iOS13 SDK and newer). XCTest has no allocation
+// metric, memory is the nearest one. Older SDKs and systems, down to the iOS7.1 deployment target, only measure wall clock time
+- (void)_measureBlock:(void (^)(void))block
+{
+#if __IPHONE_OS_VERSION_MAX_ALLOWED >= 130000
+    if ( @available(iOS 13.0, *) )
+    {
+        NSArray *metrics = @[[[XCTClockMetric alloc] init], [[XCTCPUMetric alloc] init], [[XCTMemoryMetric alloc] init]];
+        [self measureWithMetrics:metrics block:block];
+        return;
+    }
+#endif
+    
+    [self measureBlock:block];
+}
+
+
+- (NSArray*)_buttonItems
+{
+    NSMutableArray *items = [NSMutableArray array];
+    for ( NSInteger i=0 ; i<_itemCount ; i++ )
+    {
+        SWCellButtonItem *item = _iconItems ?
+            [SWCellButtonItem itemWithImage:[self _iconImage] handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell) {}] :
+            [SWCellButtonItem itemWithTitle:[NSString stringWithFormat:@"Action\nNumber %ld", (long)i]
+                handler:^(SWCellButtonItem *item, SWRevealTableViewCell *cell) {}];
+        
+        if ( _iconItems ) item.renderingMode = SWCellButtonItemRenderingModeLayer;
+
+        item.backgroundColor = [UIColor colorWithHue:i/8.0f saturation:0.8f brightness:0.8f alpha:1.0f];
+        item.tintColor = [UIColor whiteColor];
+        item.width = _automaticWidths ? SWCellButtonItemAutomaticWidth : 75;
+        [items addObject:item];
+    }
+    return items;
+}
+
+
+- (UIImage*)_iconImage
+{
+    // a single image for all the icons, as it would be with images loaded by name
+    if ( _iconImage == nil )
+    {
+        UIGraphicsBeginImageContextWithOptions(CGSizeMake(24, 24), NO, 0);
+        [[UIBezierPath bezierPathWithOvalInRect:CGRectMake(2, 2, 20, 20)] fill];
+        _iconImage = UIGraphicsGetImageFromCurrentImageContext();
+        UIGraphicsEndImageContext();
+    }
+    return _iconImage;
+}
+
+
+- (SWRevealTableViewCell*)_cellInWindow
+{
+    SWRevealTableViewCell *cell = [[SWRevealTableViewCell alloc] initWithStyle:UITableViewCellStyleSubtitle reuseIdentifier:nil];
+    cell.frame = CGRectMake(0, 0, 320, 60);
+    cell.dataSource = self;
+    cell.textLabel.text = @"Benchmark cell";
+
+    [_window addSubview:cell];
+    [cell layoutIfNeeded];
+
+    return cell;
+}
+
+
+- (void)_measureDeployUndeployCyclesWithItemCount:(NSInteger)itemCount
+{
+    _itemCount = itemCount;
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+
+    [self _measureBlock:^
+    {
+        for ( NSInteger i=0 ; i<BenchmarkIterations ; i++ )
+        {
+            [cell setRevealPosition:SWCellRevealPositionLeft animated:NO];
+            [cell setRevealPosition:SWCellRevealPositionCenter animated:NO];
+            [cell setRevealPosition:SWCellRevealPositionRight animated:NO];
+            [cell setRevealPosition:SWCellRevealPositionCenter animated:NO];
+        }
+    }];
+
+    XCTAssertEqual(cell.revealPosition, SWCellRevealPositionCenter);
+}
+
+
+- (void)_measurePanSequencesWithConfiguration:(void(^)(SWRevealTableViewCell *cell))configuration
+{
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+    if ( configuration ) configuration(cell);
+
+    SyntheticPanGestureRecognizer *recognizer = [[SyntheticPanGestureRecognizer alloc] init];
+
+    [self _measureBlock:^
+    {
+        for ( NSInteger i=0 ; i<BenchmarkIterations/10 ; i++ )
+        {
+            // drag to the left past the reveal width and back, then release with no velocity
+            recognizer.syntheticTranslation = 0;
+            recognizer.syntheticVelocity = 0;
+            [cell _handleRevealGestureStateBeganWithRecognizer:recognizer];
+
+            for ( NSInteger step=0 ; step<BenchmarkPanSteps ; step++ )
+            {
+                CGFloat progress = (CGFloat)step/BenchmarkPanSteps;
+                recognizer.syntheticTranslation = -300*sinf(M_PI*progress);
+                [cell _handleRevealGestureStateChangedWithRecognizer:recognizer];
+            }
+
+            [cell _handleRevealGestureStateEndedWithRecognizer:recognizer];
+        }
+    }];
+}
+
+
+- (void)_measureReplaysOfTrace:(GestureTrace*)trace configuration:(void(^)(SWRevealTableViewCell *cell))configuration
+{
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+    if ( configuration ) configuration(cell);
+
+    SyntheticPanGestureRecognizer *recognizer = [[SyntheticPanGestureRecognizer alloc] init];
+    __block GestureReplay *replay = nil;
+    cell.metricsDelegate = self;
+
+    [self _measureBlock:^
+    {
+        for ( NSInteger i=0 ; i<BenchmarkIterations/10 ; i++ )
+        {
+            replay = [GestureReplay replayTrace:trace onCell:cell recognizer:recognizer frameInterval:BenchmarkFrameInterval];
+        }
+    }];
+
+    // direct updates lay out once per changed sample. Coalesced updates lay out at most once per simulated display frame,
+    // and as touch samples come faster than frames, that is fewer times than direct updates would
+    NSInteger directPasses = trace.sampleCount-1;
+    XCTAssertNotNil(_gestureMetrics, @"%@", replay);
+    
+    if ( cell.coalescesPanGestureUpdates )
+    {
+        XCTAssertTrue(_gestureMetrics.frameCount <= (NSInteger)replay.frameDurations.count, @"%@", replay);
+        XCTAssertTrue(_gestureMetrics.frameCount < directPasses, @"%@", replay);
+    }
+    else
+    {
+        XCTAssertEqual(_gestureMetrics.frameCount, directPasses, @"%@", replay);
+    }
+    
+    XCTAssertTrue(replay.worstFrameDuration <= replay.totalDuration, @"%@", replay);
+}
+
+
+// Returns the number of layout passes performed by the cell while replaying the trace
+- (NSInteger)_layoutPassesReplayingTrace:(GestureTrace*)trace coalescingUpdates:(BOOL)coalesces
+{
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+    cell.coalescesPanGestureUpdates = coalesces;
+    cell.metricsDelegate = self;
+    
+    _gestureMetrics = nil;
+    SyntheticPanGestureRecognizer *recognizer = [[SyntheticPanGestureRecognizer alloc] init];
+    [GestureReplay replayTrace:trace onCell:cell recognizer:recognizer frameInterval:BenchmarkFrameInterval];
+    
+    XCTAssertNotNil(_gestureMetrics);
+    return _gestureMetrics.frameCount;
+}
+
+
+- (GestureTrace*)_dragAndReleaseTrace
+{
+    // drag to the left past the reveal width and back at 120Hz touch rate, then release with no velocity
+    return [GestureTrace traceWithDuration:1.0 sampleRate:120 translation:^CGFloat(CGFloat progress)
+    {
+        return -300*sinf(M_PI*progress);
+    }];
+}
+
+
+- (UITableView*)_tableViewInWindow
+{
+    UITableView *tableView = [[UITableView alloc] initWithFrame:_window.bounds style:UITableViewStylePlain];
+    tableView.dataSource = self;
+    tableView.rowHeight = 60;
+    [tableView registerClass:[SWRevealTableViewCell class] forCellReuseIdentifier:BenchmarkCellReuseIdentifier];
+
+    [_window addSubview:tableView];
+    [tableView layoutIfNeeded];
+
+    return tableView;
+}
+
+
+- (void)_measureScrollWithReuseInTableView:(UITableView*)tableView
+{
+    CGFloat maxOffset = tableView.contentSize.height - tableView.bounds.size.height;
+
+    [self _measureBlock:^
+    {
+        // scroll through all the rows a screen at a time, this will cause each row to be dequeued and configured
+        for ( CGFloat offset=0 ; offset<maxOffset ; offset+=tableView.bounds.size.height )
+        {
+            [tableView setContentOffset:CGPointMake(0, offset)];
+            [tableView layoutIfNeeded];
+        }
+
+        [tableView setContentOffset:CGPointZero];
+        [tableView layoutIfNeeded];
+    }];
+}
+
+
+#pragma mark - SWRevealTableViewCellDelegate
+
+- (void)revealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell didMoveToPosition:(SWCellRevealPosition)position
+{
+    [_movedPositions addObject:@(position)];
+}
+
+
+#pragma mark - SWRevealTableViewCellMetricsDelegate
+
+- (void)revealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell didEndPanGestureWithMetrics:(SWRevealGestureMetrics *)metrics
+{
+    _gestureMetrics = metrics;
+}
+
+
+#pragma mark - SWRevealTableViewCellDataSource
+
+- (NSArray*)leftButtonItemsInRevealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell
+{
+    return [self _buttonItems];
+}
+
+
+- (NSArray*)rightButtonItemsInRevealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell
+{
+    return [self _buttonItems];
+}
+
+
+#pragma mark - UITableViewDataSource
+
+- (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section
+{
+    return BenchmarkRowCount;
+}
+
+
+- (UITableViewCell *)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    SWRevealTableViewCell *cell = [tableView dequeueReusableCellWithIdentifier:BenchmarkCellReuseIdentifier forIndexPath:indexPath];
+    cell.dataSource = self;
+    cell.textLabel.text = [NSString stringWithFormat:@"Row %ld", (long)indexPath.row];
+
+    [_coordinator configureCell:cell forRowAtIndexPath:indexPath];
+
+    return cell;
+}
+
+
+#pragma mark - Deploy and undeploy
+
+- (void)testDeployUndeployCyclesWithOneItem
+{
+    [self _measureDeployUndeployCyclesWithItemCount:1];
+}
+
+
+- (void)testDeployUndeployCyclesWithThreeItems
+{
+    [self _measureDeployUndeployCyclesWithItemCount:3];
+}
+
+
+- (void)testDeployUndeployCyclesWithEightItems
+{
+    [self _measureDeployUndeployCyclesWithItemCount:8];
+}
+
+
+- (void)testDeployUndeployCyclesWithAutomaticWidths
+{
+    _automaticWidths = YES;
+    [self _measureDeployUndeployCyclesWithItemCount:3];
+}
+
+
+- (void)testDeployUndeployCyclesWithIconItems
+{
+    _iconItems = YES;
+    [self _measureDeployUndeployCyclesWithItemCount:3];
+}
+
+
+- (void)testDeployUndeployCyclesWithPrivateViewPool
+{
+    SWUtilityViewPool *pool = [[SWUtilityViewPool alloc] init];
+    pool.maximumPooledViewCount = 0;
+
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+    cell.utilityViewPool = pool;
+
+    // with no pooled views, this measures the cost of creating utility views on each deployment
+    [self _measureBlock:^
+    {
+        for ( NSInteger i=0 ; i<BenchmarkIterations ; i++ )
+        {
+            [cell setRevealPosition:SWCellRevealPositionLeft animated:NO];
+            [cell setRevealPosition:SWCellRevealPositionCenter animated:NO];
+        }
+    }];
+}
+
+
+#pragma mark - Pan sequences
+
+- (void)testPanSequences
+{
+    [self _measurePanSequencesWithConfiguration:nil];
+}
+
+
+- (void)testPanSequencesCoalescingUpdates
 {
-    XCTFail(@"No implementation for \"%s\"", __PRETTY_FUNCTION__);
+    [self _measurePanSequencesWithConfiguration:^(SWRevealTableViewCell *cell)
+    {
+        cell.coalescesPanGestureUpdates = YES;
+    }];
+}
+
+
+- (void)testPanSequencesUsingTransforms
+{
+    [self _measurePanSequencesWithConfiguration:^(SWRevealTableViewCell *cell)
+    {
+        cell.revealsUsingTransforms = YES;
+    }];
+}
+
+
+- (void)testPanSequencesRasterizingItems
+{
+    [self _measurePanSequencesWithConfiguration:^(SWRevealTableViewCell *cell)
+    {
+        cell.rasterizesButtonItemsDuringGesture = YES;
+    }];
+}
+
+
+- (void)testPanSequencesUsingLayers
+{
+    [self _measurePanSequencesWithConfiguration:^(SWRevealTableViewCell *cell)
+    {
+        cell.layoutsButtonItemsUsingLayers = YES;
+    }];
+}
+
+
+- (void)testPanSequencesWithFixedLayout
+{
+    [self _measurePanSequencesWithConfiguration:^(SWRevealTableViewCell *cell)
+    {
+        cell.layoutStrategy = [SWRevealLayout layoutWithStyle:SWRevealLayoutStyleFixed];
+    }];
+}
+
+
+- (void)testPanSequencesWithParallaxLayout
+{
+    [self _measurePanSequencesWithConfiguration:^(SWRevealTableViewCell *cell)
+    {
+        cell.layoutStrategy = [SWRevealLayout layoutWithStyle:SWRevealLayoutStyleParallax];
+    }];
+}
+
+
+- (void)testStretchItemsFillRevealedAreaOnOverdraw
+{
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+    cell.layoutStrategy = [SWRevealLayout layoutWithStyle:SWRevealLayoutStyleStretch];
+    
+    // drag to the left well past the reveal width, the front view moves to the damped location
+    SyntheticPanGestureRecognizer *recognizer = [[SyntheticPanGestureRecognizer alloc] init];
+    [cell _handleRevealGestureStateBeganWithRecognizer:recognizer];
+    recognizer.syntheticTranslation = -400;
+    [cell _handleRevealGestureStateChangedWithRecognizer:recognizer];
+    
+    CGFloat revealedWidth = -[[cell valueForKey:@"_revealLocation"] doubleValue];
+    XCTAssertTrue(revealedWidth > 75*_itemCount);
+    XCTAssertTrue(revealedWidth < 400);
+    
+    // right items are laid out from the cell trailing edge, their extent must be the revealed width
+    CGFloat minX = CGRectGetWidth(cell.bounds);
+    NSArray *rightViews = [[cell valueForKey:@"_utilityContentView"] valueForKey:@"_rightViews"];
+    XCTAssertEqual(rightViews.count, (NSUInteger)_itemCount);
+    
+    for ( UIView *utilityView in rightViews )
+        minX = MIN(minX, CGRectGetMinX(utilityView.frame));
+    
+    XCTAssertEqualWithAccuracy(CGRectGetWidth(cell.bounds)-minX, revealedWidth, 1.0);
+    
+    [cell _handleRevealGestureStateCancelledWithRecognizer:recognizer];
+}
+
+
+#pragma mark - Replayed gestures
+
+- (void)testReplayedDragAndRelease
+{
+    [self _measureReplaysOfTrace:[self _dragAndReleaseTrace] configuration:nil];
+}
+
+
+- (void)testReplayedDragAndReleaseCoalescingUpdates
+{
+    [self _measureReplaysOfTrace:[self _dragAndReleaseTrace] configuration:^(SWRevealTableViewCell *cell)
+    {
+        cell.coalescesPanGestureUpdates = YES;
+    }];
+}
+
+
+- (void)testReplayedDragCoalescesLayoutPasses
+{
+    // touch samples come at twice the frame rate, so coalescing must apply fewer layout passes for the same trace
+    GestureTrace *trace = [self _dragAndReleaseTrace];
+    NSInteger directPasses = [self _layoutPassesReplayingTrace:trace coalescingUpdates:NO];
+    NSInteger coalescedPasses = [self _layoutPassesReplayingTrace:trace coalescingUpdates:YES];
+    
+    XCTAssertEqual(directPasses, trace.sampleCount-1);
+    XCTAssertTrue(coalescedPasses < directPasses);
+}
+
+
+- (void)testReplayedCancelledDrag
+{
+    GestureTrace *trace = [self _dragAndReleaseTrace];
+    trace.cancelled = YES;
+    [self _measureReplaysOfTrace:trace configuration:nil];
+}
+
+
+- (void)testReplayedRecordedFlick
+{
+    // a short flick to the left as recorded on a device, touch events are not evenly spaced
+    GestureTrace *trace = [GestureTrace traceWithPropertyList:@[
+        @[@0.000, @0, @0], @[@0.009, @-6, @-640], @[@0.017, @-19, @-1560], @[@0.025, @-38, @-2310],
+        @[@0.034, @-64, @-2900], @[@0.042, @-93, @-3480], @[@0.051, @-121, @-3150], @[@0.059, @-146, @-3000],
+        @[@0.076, @-184, @-2280], @[@0.084, @-197, @-1560], @[@0.093, @-205, @-940],
+    ]];
+    
+    [self _measureReplaysOfTrace:trace configuration:^(SWRevealTableViewCell *cell)
+    {
+        cell.coalescesPanGestureUpdates = YES;
+    }];
+}
+
+
+#pragma mark - Programmatic requests
+
+- (void)testEnqueueingOpenCloseStorm
+{
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+
+    // the run loop does not run in here, so the first animated request never completes and all the following ones
+    // are coalesced into a single pending request. This measures enqueueing and coalescing, not the animations
+    [self _measureBlock:^
+    {
+        for ( NSInteger i=0 ; i<BenchmarkIterations*10 ; i++ )
+        {
+            [cell setRevealPosition:(i%2 ? SWCellRevealPositionCenter : SWCellRevealPositionLeft) animated:YES];
+        }
+    }];
+}
+
+
+- (void)testMixedRequestsQueuedDuringAnimation
+{
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+    [cell setRevealPosition:SWCellRevealPositionLeft animated:NO];
+    
+    _movedPositions = [NSMutableArray array];
+    cell.delegate = self;
+    
+    // while the animation is in process, queue more requests than the queue holds, mixing position and reload requests
+    [cell setRevealPosition:SWCellRevealPositionCenter animated:YES];
+    [cell setRevealPosition:SWCellRevealPositionLeft animated:NO];
+    [cell reloadButtonItemsAnimated:NO];
+    [cell setRevealPosition:SWCellRevealPositionRight animated:NO];
+    [cell reloadButtonItemsAnimated:NO];
+    [cell reloadButtonItemsAnimated:YES];
+    
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:2*cell.revealAnimationDuration+0.1]];
+    
+    // only the latest pending position is performed, after the pending reload, and the queue is drained
+    // so a new request is performed right away
+    XCTAssertEqualObjects(_movedPositions, (@[@(SWCellRevealPositionCenter), @(SWCellRevealPositionRight)]));
+    XCTAssertEqual(cell.revealPosition, SWCellRevealPositionRight);
+    XCTAssertEqual(cell.leftCellButtonItems.count, (NSUInteger)_itemCount);
+    
+    [cell setRevealPosition:SWCellRevealPositionCenter animated:NO];
+    XCTAssertEqual(cell.revealPosition, SWCellRevealPositionCenter);
+}
+
+
+- (void)testReloadButtonItemsOfRevealedCell
+{
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+    [cell setRevealPosition:SWCellRevealPositionLeft animated:NO];
+    
+    // the data source returns equal items each time, so utility views are kept and nothing needs to be set on them
+    [self _measureBlock:^
+    {
+        for ( NSInteger i=0 ; i<BenchmarkIterations ; i++ )
+        {
+            [cell reloadButtonItemsAnimated:NO];
+        }
+    }];
+    
+    XCTAssertEqual(cell.revealPosition, SWCellRevealPositionLeft);
+    XCTAssertEqual(cell.rightCellButtonItems.count, (NSUInteger)_itemCount);
+}
+
+
+#pragma mark - Resources
+
+- (void)testReleaseIdleResourcesOfPrewarmedCell
+{
+    SWRevealTableViewCell *cell = [self _cellInWindow];
+    
+    // prewarming happens on the next run loop pass
+    [cell prepareButtonItemsIfNeeded];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    
+    XCTAssertEqual(cell.resourceUsage.itemCount, (NSUInteger)2*_itemCount);
+    XCTAssertEqual(cell.resourceUsage.utilityViewCount, (NSUInteger)2*_itemCount);
+    
+    [cell releaseIdleResources];
+    
+    XCTAssertEqual(cell.resourceUsage.itemCount, (NSUInteger)0);
+    XCTAssertEqual(cell.resourceUsage.utilityViewCount, (NSUInteger)0);
+    XCTAssertTrue([SWRevealTableViewCell globalResourceUsage].pooledViewCount >= (NSUInteger)2*_itemCount);
+}
+
+
+#pragma mark - Scrolling
+
+- (void)testScrollWithReuse
+{
+    UITableView *tableView = [self _tableViewInWindow];
+    [self _measureScrollWithReuseInTableView:tableView];
+}
+
+
+- (void)testScrollWithReuseRestoringRevealedRow
+{
+    UITableView *tableView = [self _tableViewInWindow];
+    _coordinator = [[SWRevealTableViewCellCoordinator alloc] initWithTableView:tableView];
+    
+    // visible cells were loaded before the coordinator existed, get them configured with it
+    [tableView reloadData];
+    [tableView layoutIfNeeded];
+
+    SWRevealTableViewCell *cell = (id)[tableView cellForRowAtIndexPath:[NSIndexPath indexPathForRow:0 inSection:0]];
+    [cell setRevealPosition:SWCellRevealPositionLeft animated:NO];
+    XCTAssertEqualObjects(_coordinator.revealedIndexPath, [NSIndexPath indexPathForRow:0 inSection:0]);
+
+    [self _measureScrollWithReuseInTableView:tableView];
+
+    // the row went off screen, so its cell was reused, the cell we get for it now must come back revealed
+    SWRevealTableViewCell *restoredCell = (id)[tableView cellForRowAtIndexPath:[NSIndexPath indexPathForRow:0 inSection:0]];
+    XCTAssertNotNil(restoredCell);
+    XCTAssertEqual(restoredCell.revealPosition, SWCellRevealPositionLeft);
+    XCTAssertEqual(restoredCell.rightCellButtonItems.count, (NSUInteger)_itemCount);
 }
 
 @end
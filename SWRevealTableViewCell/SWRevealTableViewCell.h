@@ -32,7 +32,34 @@
 
  RELEASE NOTES
 
- Version 0.2.1 (Current Version)
+ Version 0.3.0 (Current Version)
+    - Added SWUtilityViewPool class and 'utilityViewPool' property, utility views are now reused among cells
+    - Solid color images for title items are now cached
+    - Reveal widths and item frames are now computed from cached item offsets
+    - Added property 'coalescesPanGestureUpdates'
+    - Added property 'revealsUsingTransforms'
+    - Added optional data source methods 'revealTableViewCellHasLeftButtonItems:', 'revealTableViewCellHasRightButtonItems:'
+    - Added optional data source method 'buttonItemsSignatureForRevealTableViewCell:' and class method 'purgeButtonItemsCache'
+    - Added method 'prepareButtonItemsIfNeeded' and UITableView category extension
+    - Programmatic position requests received during an animation are now coalesced, only the last one is performed
+    - Reveal animations can now be interrupted by a pan gesture, the gesture end velocity is passed to the animation
+    - Added SWRevealTableViewCellCoordinator class and 'coordinator' property
+    - Added method 'restoreRevealPosition:' and coordinator property 'rowIdentifierProvider', reused cells restore their position silently
+    - Added property 'rasterizesButtonItemsDuringGesture'
+    - Added property 'layoutsButtonItemsUsingLayers'
+    - Added os_signpost instrumentation enabled by SupportsSignposts, added SWRevealGestureMetrics class and 'metricsDelegate' property
+    - Added class method 'setRevealPosition:forCells:animated:completion:'
+    - Added SWCellButtonItemAutomaticWidth constant for item widths measured by the cell
+    - Added SWCellButtonItem constructors for images decoded in the background
+    - Added SWRevealLayoutStrategy protocol, SWRevealLayout class and 'layoutStrategy' property
+    - Optional delegate methods are now checked once when the delegate is set
+    - Added properties 'panDirectionThreshold', 'panDirectionMaximumAngle' and coordinator property 'suspendsRevealWhileScrolling'
+    - Added method 'reloadButtonItemsAnimated:', revealed items are updated in place
+    - Added SWCellButtonItem property 'renderingMode' for image only items shown with a single layer
+    - Added SWRevealResourceUsage class, 'resourceUsage', 'idleResourceTimeout' properties and methods to release idle resources
+    - Added SWCellButtonItemMenu class, reusable action menus presented with UIAlertController, replaces the UIActionSheet category
+
+ Version 0.2.1
     - Bug fixes and some refactoring (on UIActionSheet category and layout)
  
  Version 0.2.0
@@ -52,12 +79,35 @@
 
 #define SupportsVisualEffects false
 
+// Set this to true to emit os_signpost intervals for the reveal and layout paths. Requires the iOS 12 SDK and a deployment
+// target of iOS 12 or above. When false, no instrumentation code is compiled at all
+#ifndef SupportsSignposts
+#define SupportsSignposts false
+#endif
+
 @class SWRevealTableViewCell;
+@class SWRevealTableViewCellCoordinator;
+@class SWRevealGestureMetrics;
+@class SWRevealResourceUsage;
 @class UIVisualEffect;
 
 
 #pragma mark - SWCellButtonItem
 
+// Use this as the width of a cell button item to get it measured from its title and image. Measurements are cached
+// per title, image size and content size category, and they are redone when the user changes the Dynamic Type size
+extern const CGFloat SWCellButtonItemAutomaticWidth;
+
+// How a cell button item is shown. Items rendered using a layer have no button, their image is shown as the contents of a single
+// layer over their background color, tinted with their tint color unless the image rendering mode is UIImageRenderingModeAlwaysOriginal.
+// Taps on them are handled by a single recognizer shared by all the items of the cell. This only applies to image only items with
+// no visual effect, other items are always shown with a button. Icons are kept centered on the revealed part of the item
+typedef NS_ENUM(NSInteger, SWCellButtonItemRenderingMode)
+{
+    SWCellButtonItemRenderingModeButton = 0,
+    SWCellButtonItemRenderingModeLayer,
+};
+
 /* A cell button item SWCellButtonItem is a button specialized for revealing behind a SWRevealTableViewCell.
    It is conceptually similar to a UIBarButtonItem except that instances do not implement a target and a action,
    instead, a handler block must be provided to execute derived actions */
@@ -67,13 +117,23 @@
 + (instancetype)itemWithTitle:(NSString*)title handler:(void(^)(SWCellButtonItem *item, SWRevealTableViewCell* cell))handler;
 + (instancetype)itemWithImage:(UIImage*)image handler:(void(^)(SWCellButtonItem *item, SWRevealTableViewCell* cell))handler;
 
-@property(nonatomic) CGFloat width;              // default is 0.0
+// Items created with the following methods get their image loaded, decoded and downsampled to fit the given point size on a
+// background queue, the placeholder image is shown until then. Decoded images are cached by URL or identifier and size.
+// The provider block is called on a background queue and it should return the full size image. Pass a nil identifier to
+// prevent caching of provided images
++ (instancetype)itemWithImageURL:(NSURL*)imageURL size:(CGSize)size placeholder:(UIImage*)placeholder
+    handler:(void(^)(SWCellButtonItem *item, SWRevealTableViewCell* cell))handler;
++ (instancetype)itemWithImageProvider:(UIImage*(^)(void))provider identifier:(id<NSCopying>)identifier size:(CGSize)size
+    placeholder:(UIImage*)placeholder handler:(void(^)(SWCellButtonItem *item, SWRevealTableViewCell* cell))handler;
+
+@property(nonatomic) CGFloat width;              // default is 0.0, set to SWCellButtonItemAutomaticWidth to fit the title and image
 @property(nonatomic) UIImage *image;             // default is nil
-@property(nonatomic, weak) UIButton *button;     // default is nil
+@property(nonatomic, weak) UIButton *button;     // default is nil, always nil for items rendered using a layer
 @property(nonatomic) UIColor *backgroundColor;   // default is nil
 @property(nonatomic) UIColor *tintColor;         // default is nil
 @property(nonatomic) NSString *title;            // default is nil
 @property(nonatomic) UIVisualEffect *visualEffect;
+@property(nonatomic) SWCellButtonItemRenderingMode renderingMode;   // default is SWCellButtonItemRenderingModeButton
 
 @end
 
@@ -97,22 +157,75 @@ typedef NS_ENUM(NSUInteger, SWCellRevealPosition)
 
 #pragma mark - UIActionSheetExtension
 
+// UIActionSheet is deprecated as of iOS8, use SWCellButtonItemMenu instead
 @interface UIActionSheet(SWCellButtonItem)
 - (void)showFromCellButtonItem:(SWCellButtonItem *)item animated:(BOOL)animated;
 @end
 
 
+#pragma mark - SWCellButtonItemMenu
+
+/* An action menu anchored to a cell button item. It is presented with a UIAlertController, or with a UIActionSheet on iOS7.
+   Create a menu once for a given set of actions and keep it, the same menu can be presented from any cell. The menu only keeps
+   the action descriptions, a new controller is built from them on each presentation */
+
+@interface SWCellButtonItemMenu : NSObject
+
++ (instancetype)menuWithTitle:(NSString*)title message:(NSString*)message;
+
+@property (nonatomic, readonly) NSString *title;
+@property (nonatomic, readonly) NSString *message;
+
+// Adds an action to the receiver. Action handlers get the item and the cell the menu was presented from.
+// Only one action can have the UIAlertActionStyleCancel style, it is called when the menu is dismissed with no action
+- (void)addActionWithTitle:(NSString*)title style:(UIAlertActionStyle)style
+    handler:(void(^)(SWCellButtonItem *item, SWRevealTableViewCell* cell))handler;
+
+// Presents the receiver anchored to the given item, which must be deployed. The item frame is taken from the cell cached item offsets.
+// Has no effect if the receiver is already presented
+- (void)presentFromCellButtonItem:(SWCellButtonItem*)item inViewController:(UIViewController*)viewController animated:(BOOL)animated;
+
+@end
+
+
+#pragma mark - SWUtilityViewPool
+
+/* A reuse pool for the views that present cell button items. Views are returned to the pool when items are undeployed
+   and taken from it on the next deployment, so revealing a cell does not allocate new views once the pool is warm.
+   Views are kept separately for each item configuration (title, image, combined title and image, visual effect).
+   By default all cells share the sharedPool instance, you can assign a different pool to cells of a particular table.
+   Pools are automatically purged on memory warnings */
+
+@interface SWUtilityViewPool : NSObject
+
++ (instancetype)sharedPool;
+
+// Maximum number of idle views kept for each item configuration, default is 16
+@property (nonatomic) NSUInteger maximumPooledViewCount;
+
+// Releases all idle views held by the receiver
+- (void)purge;
+
+// Number of idle views currently held by the receiver
+@property (nonatomic, readonly) NSUInteger pooledViewCount;
+
+@end
+
+
 #pragma mark - SWRevealTableViewCell
 
 /* A UITableViewCell subclass capable of presenting right and left utility views similar to the Mail app */
 
 @protocol SWRevealTableViewCellDelegate;
 @protocol SWRevealTableViewCellDataSource;
+@protocol SWRevealTableViewCellMetricsDelegate;
+@protocol SWRevealLayoutStrategy;
 
 @interface SWRevealTableViewCell : UITableViewCell
 {
     // The SWRevealTableViewCell is meant to be overriden,
     // thus we allow protected access to the _delegate ivar, this also prevents redeclaration of the same
+    // note that optional delegate methods are looked up in setDelegate:, subclasses should not assign _delegate directly
     id __weak _delegate;
 }
 
@@ -127,10 +240,30 @@ typedef NS_ENUM(NSUInteger, SWCellRevealPosition)
 @property (nonatomic, readonly) NSArray *rightCellButtonItems;
 
 // Front view position, use this to programmatically set a particular position to the cell
-// If you call the animated version several times in a row animations will be chained and performed one after the other.
+// If you call the animated version while an animation or a gesture is in progress, the new position will be animated after it completes.
+// Only the last requested position is kept, intermediate requests are discarded.
 @property (nonatomic) SWCellRevealPosition revealPosition;
 - (void)setRevealPosition:(SWCellRevealPosition)revealPosition animated:(BOOL)animated;
 
+// Sets the position of several cells at once. All cells are laid out in a single pass, inside a single animation block if animated,
+// and a single completion is called when all of them are done. Delegate willMove methods are called for all cells before
+// the animation starts and didMove methods are called for all cells when it ends. Cells that are not on screen, or that are
+// busy with other requests, just get the new position as with setRevealPosition:animated:
+// You can use this for bulk operations such as closing all the visible cells of a table with [tableView visibleCells]
++ (void)setRevealPosition:(SWCellRevealPosition)revealPosition forCells:(id<NSFastEnumeration>)cells animated:(BOOL)animated
+    completion:(void (^)(void))completion;
+
+// Asks the data source again for the button items of the sides already prepared and updates them in place. Utility views are kept
+// for items that are still there, and reused for items replacing another one of the same kind at the same index, so only changed
+// titles, images and colors are set. Inserted and removed items fade in and out while the cell adjusts to the new reveal width.
+// If the revealed side is left with no items the cell goes back to center. Items built for a data source signature are cached,
+// so return a different signature for the new items. See buttonItemsSignatureForRevealTableViewCell:
+- (void)reloadButtonItemsAnimated:(BOOL)animated;
+
+// Sets the front view position right away, without animation and without calling the delegate willMove/didMove methods.
+// Use this to restore a previously saved position on a reused cell, typically from tableView:cellForRowAtIndexPath:
+- (void)restoreRevealPosition:(SWCellRevealPosition)revealPosition;
+
 // Determines whether users can reveal items while the receiver is in editing mode
 @property (nonatomic) BOOL allowsRevealInEditMode;
 
@@ -153,19 +286,239 @@ typedef NS_ENUM(NSUInteger, SWCellRevealPosition)
 // default is 0 which means no restriction.
 @property (nonatomic) CGFloat draggableBorderWidth;
 
+// Distance in points a touch must move before the pan gesture decides whether it is a horizontal reveal or a vertical scroll,
+// default is 5. Lower values let vertical scrolls be rejected earlier
+@property (nonatomic) CGFloat panDirectionThreshold;
+
+// Maximum angle in degrees from the horizontal for a move past panDirectionThreshold to be taken as a reveal, moves at a steeper angle
+// make the pan gesture fail. Default is 90, which means horizontal moves past the threshold are always taken
+@property (nonatomic) CGFloat panDirectionMaximumAngle;
+
+// If YES, pan gesture updates are applied at most once per display refresh instead of once per touch event.
+// Layout and the panGestureMovedToLocation:progress: delegate call will happen from a display link, default is NO
+@property (nonatomic) BOOL coalescesPanGestureUpdates;
+
+// If YES, the cell contentView and its siblings are moved by setting a translation transform instead of offsetting
+// their frames, so dragging does not require any cell layout. Has no effect on iOS7, default is NO
+@property (nonatomic) BOOL revealsUsingTransforms;
+
+// If YES, button items are rendered once to a bitmap when a pan gesture begins, and the bitmaps are shown instead of the live
+// buttons until the cell settles, so their title and image layout does not run while dragging. Items with a visual effect are
+// always shown live. Default is NO
+@property (nonatomic) BOOL rasterizesButtonItemsDuringGesture;
+
+// If YES, utility views are laid out by directly setting the position and bounds of their layers, with all the items of both sides
+// updated in a single transaction with implicit actions disabled. This bypasses UIView frame setting and the autoresizing of item
+// buttons, which are only laid out again when the cell height changes. Default is NO
+@property (nonatomic) BOOL layoutsButtonItemsUsingLayers;
+
+// The strategy that lays out utility views as the cell is revealed. Default is nil, which is the same as the cascade built in layout.
+// See SWRevealLayoutStrategy and SWRevealLayout
+@property (nonatomic) id <SWRevealLayoutStrategy> layoutStrategy;
+
+// The pool from where utility views are taken when items are deployed, default is [SWUtilityViewPool sharedPool].
+// Assign the same pool to all cells of a table view to share views among them. Setting nil restores the shared pool
+@property (nonatomic) SWUtilityViewPool *utilityViewPool;
+
+// The coordinator in charge of keeping a single revealed cell on a table view, default is nil. See SWRevealTableViewCellCoordinator
+@property (nonatomic, weak) SWRevealTableViewCellCoordinator *coordinator;
+
+// Set a metrics delegate to get statistics on each pan gesture. No measurements are taken when this is nil, default is nil
+@property (nonatomic, weak) id <SWRevealTableViewCellMetricsDelegate> metricsDelegate;
+
+// Call this to get the receiver's items and utility views built during idle run loop time, typically from your
+// tableView:willDisplayCell:forRowAtIndexPath: implementation. Views are kept hidden until the cell is actually revealed,
+// so the first drag frame does not need to build anything. Has no effect on cells that are not centered
+- (void)prepareButtonItemsIfNeeded;
+
+// Removes all item arrays cached through the buttonItemsSignatureForRevealTableViewCell: data source method
++ (void)purgeButtonItemsCache;
+
+// Resources currently held by the receiver. Pooled view and cache counts are only reported by globalResourceUsage
+@property (nonatomic, readonly) SWRevealResourceUsage *resourceUsage;
+
+// Resources currently held by all cells, along with the views kept by utility view pools and the shared caches
++ (SWRevealResourceUsage *)globalResourceUsage;
+
+// Time after which the items and views of a cell prewarmed by prepareButtonItemsIfNeeded are released if the cell did not get revealed,
+// default is 0, which means they are kept until the cell gets reused or leaves its window. Hidden cells release them right away
+@property (nonatomic) NSTimeInterval idleResourceTimeout;
+
+// Releases the items and prewarmed views of the receiver, along with the handler blocks they retain. Has no effect on cells that are
+// not centered or that are performing a position change
+- (void)releaseIdleResources;
+
+// Calls releaseIdleResources on all cells, and purges utility view pools, item arrays and image caches. This is automatically
+// called on UIApplicationDidReceiveMemoryWarningNotification
++ (void)releaseAllIdleResources;
+
+@end
+
+
+#pragma mark - UITableViewExtension
+
+@interface UITableView(SWRevealTableViewCell)
+// Calls prepareButtonItemsIfNeeded on the SWRevealTableViewCells currently loaded for the given index paths.
+// Rows without a loaded cell are ignored, you can call this from your UITableViewDataSourcePrefetching methods and
+// again from tableView:willDisplayCell:forRowAtIndexPath: to cover them
+- (void)prepareRevealButtonItemsForRowsAtIndexPaths:(NSArray *)indexPaths;
+@end
+
+
+#pragma mark - SWRevealLayoutStrategy
+
+/* A reveal layout strategy computes the frames of the utility views on one side of a cell for a given reveal progress.
+   Strategy methods are looked up once, when the strategy is set on a cell, so custom strategies add no per frame
+   message lookup. Built in strategies are provided by the SWRevealLayout class. */
+
+@protocol SWRevealLayoutStrategy <NSObject>
+
+@required
+// Fill 'frames' with the frames of 'count' utility views in the coordinate space of 'bounds'. 'offsets' has count+1 values,
+// offsets[i] is the sum of the widths of the items before item i, so offsets[count] is the reveal width. Items are numbered
+// from the cell edge inwards. 'progress' is the revealed fraction of the reveal width, it grows above 1 on overdraw
+- (void)revealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell getFrames:(CGRect *)frames forItemOffsets:(const CGFloat *)offsets
+    count:(NSInteger)count leftSide:(BOOL)leftSide progress:(CGFloat)progress bounds:(CGRect)bounds;
+
+@optional
+// The distance by which the overdraw damper slows down dragging beyond the reveal width, default is 80
+- (CGFloat)overdrawDamperWidth;
+
+@end
+
+
+#pragma mark - SWRevealLayout
+
+/* Built in layout styles */
+
+typedef NS_ENUM(NSInteger, SWRevealLayoutStyle)
+{
+    // Items grow from the cell edge in proportion to their widths as the cell is revealed. This is the default
+    SWRevealLayoutStyleCascade,
+
+    // Items keep their final frames and are uncovered by the moving cell
+    SWRevealLayoutStyleFixed,
+
+    // Items keep their widths and slide in at half the speed of the cell
+    SWRevealLayoutStyleParallax,
+
+    // As cascade, but items keep growing to fill the revealed area on overdraw
+    SWRevealLayoutStyleStretch,
+};
+
+
+@interface SWRevealLayout : NSObject <SWRevealLayoutStrategy>
+
++ (instancetype)layoutWithStyle:(SWRevealLayoutStyle)style;
+
+@property (nonatomic, readonly) SWRevealLayoutStyle style;
+
+@end
+
+
+#pragma mark - SWRevealGestureMetrics
+
+/* Statistics for a single pan gesture, reported to the cell metricsDelegate when the gesture ends. Times are in seconds */
+
+@interface SWRevealGestureMetrics : NSObject
+
+@property (nonatomic, readonly) NSTimeInterval duration;             // time from the beginning to the end of the gesture
+@property (nonatomic, readonly) NSInteger frameCount;                // number of pan updates applied to the cell layout
+@property (nonatomic, readonly) NSTimeInterval worstFrameDuration;   // longest time spent applying a single pan update
+@property (nonatomic, readonly) NSTimeInterval deployDuration;       // total time spent deploying utility views
+@property (nonatomic, readonly) NSInteger builtItemCount;            // number of items created by the data source
+
+@end
+
+
+#pragma mark - SWRevealResourceUsage
+
+/* Counts of resources held by cells, see resourceUsage and globalResourceUsage */
+
+@interface SWRevealResourceUsage : NSObject
+
+@property (nonatomic, readonly) NSUInteger itemCount;              // button items held by cells
+@property (nonatomic, readonly) NSUInteger utilityViewCount;       // utility views deployed on cells, prewarmed ones included
+@property (nonatomic, readonly) NSUInteger pooledViewCount;        // idle utility views held by pools
+@property (nonatomic, readonly) NSUInteger cachedImageCount;       // solid color, tinted, placeholder and decoded images held by the shared caches
+@property (nonatomic, readonly) NSUInteger cachedItemArrayCount;   // item arrays cached for data source signatures
+
+@end
+
+
+#pragma mark - SWRevealTableViewCellCoordinator
+
+/* A coordinator keeps at most one revealed cell on a table view. It closes the revealed cell when another cell starts
+   revealing or when the table view starts scrolling, and restores the revealed position of a row when its cell is reused.
+   Cells report to the coordinator directly, so your delegate methods are not involved and no visible cells are scanned.
+   Keep a strong reference to the coordinator, typically from the table view controller, and configure your cells with it
+   from tableView:cellForRowAtIndexPath: */
+
+@interface SWRevealTableViewCellCoordinator : NSObject
+
+- (instancetype)initWithTableView:(UITableView *)tableView;
+
+@property (nonatomic, weak, readonly) UITableView *tableView;
+
+// The index path of the revealed row, nil if no row is revealed
+@property (nonatomic, readonly) NSIndexPath *revealedIndexPath;
+
+// Returns a model identifier for the row at a given index path. If set, the revealed row is tracked by its identifier rather
+// than its index path, so its position is restored to the right cell after rows are inserted or deleted. Default is nil
+@property (nonatomic, copy) id<NSCopying> (^rowIdentifierProvider)(NSIndexPath *indexPath);
+
+// The revealed cell, nil if no row is revealed or if the revealed row is not currently on screen
+@property (nonatomic, weak, readonly) SWRevealTableViewCell *revealedCell;
+
+// Whether the revealed cell is closed when the user starts scrolling the table view, default is YES
+@property (nonatomic) BOOL closesOnScroll;
+
+// Whether the pan gesture recognizers of coordinated cells ignore new touches while the table view is being dragged or is
+// decelerating, so flinging through a long list does not track touches on every cell, default is YES
+@property (nonatomic) BOOL suspendsRevealWhileScrolling;
+
+// Call this from tableView:cellForRowAtIndexPath: to set the cell coordinator and to restore the cell position if the row is revealed.
+// The position is restored by calling restoreRevealPosition: on the cell
+- (void)configureCell:(SWRevealTableViewCell *)cell forRowAtIndexPath:(NSIndexPath *)indexPath;
+
+// Closes the revealed cell, if any
+- (void)closeRevealedCellAnimated:(BOOL)animated;
+
 @end
 
 
 #pragma mark - SWRevealTableViewCellDataSource
 
 // Implement the following required methods to provide left and right items.
-// Return nil if no items must be presented
+// Return nil if no items must be presented. Items are only requested for the side that is about to be revealed
 
 @protocol SWRevealTableViewCellDataSource <NSObject>
 @required
 - (NSArray*)leftButtonItemsInRevealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell;
 - (NSArray*)rightButtonItemsInRevealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell;
 
+@optional
+// Implement these to cheaply tell whether there are items on each side without building them.
+// They are used when the cell needs to know that before actually revealing a side, for example to honor draggableBorderWidth
+- (BOOL)revealTableViewCellHasLeftButtonItems:(SWRevealTableViewCell *)revealTableViewCell;
+- (BOOL)revealTableViewCellHasRightButtonItems:(SWRevealTableViewCell *)revealTableViewCell;
+
+// Implement this to return a key identifying the set of items of a cell, for example an NSString naming the action set of the row.
+// Items returned for a signature are cached and each cell returning an equal signature gets its own copies of them, so the item
+// methods above will not be called again for that signature. Item handlers get the cell where the item was tapped.
+// Return nil for cells whose items must not be cached
+- (id)buttonItemsSignatureForRevealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell;
+
+@end
+
+
+#pragma mark - SWRevealTableViewCellMetricsDelegate
+
+@protocol SWRevealTableViewCellMetricsDelegate <NSObject>
+
+// Called when a pan gesture ends or is cancelled, before the cell animates to its final position
+- (void)revealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell didEndPanGestureWithMetrics:(SWRevealGestureMetrics *)metrics;
+
 @end
 
 
@@ -26,6 +26,34 @@
 
 #import "SWRevealTableViewCell.h"
 
+#if SupportsSignposts
+#import <os/signpost.h>
+#endif
+
+
+#pragma mark - Signposts
+
+// Intervals are emitted on the main thread only, and never nest with the same name, so exclusive ids are enough
+
+#if SupportsSignposts
+static os_log_t _signpostLog(void)
+{
+    static os_log_t log = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        log = os_log_create("com.SWRevealTableViewCell", "RevealPath");
+    });
+    return log;
+}
+#define SWSignpostBegin(name) os_signpost_interval_begin(_signpostLog(), OS_SIGNPOST_ID_EXCLUSIVE, name)
+#define SWSignpostEnd(name) os_signpost_interval_end(_signpostLog(), OS_SIGNPOST_ID_EXCLUSIVE, name)
+#else
+#define SWSignpostBegin(name)
+#define SWSignpostEnd(name)
+#endif
+
+
 #pragma mark - SWCellButton Item
 
 @class SWUtilityContentView;
@@ -33,9 +61,195 @@
 @interface SWCellButtonItem()
 @property(nonatomic,strong) void (^handler)(SWCellButtonItem *, SWRevealTableViewCell*);
 @property(nonatomic,assign) SWUtilityContentView *view;
+@property(nonatomic,weak) SWRevealTableViewCell *cell;
+@property(nonatomic,assign) NSInteger index;
+@property(nonatomic,assign) CGFloat measuredWidth;
+@property(nonatomic,assign) NSUInteger measuredWidthGeneration;
+- (instancetype)_unboundCopy;
+- (void)_performHandler;
+@end
+
+
+const CGFloat SWCellButtonItemAutomaticWidth = -1.0f;
+
+
+#pragma mark - SWRevealTableViewCell(Internal)
+
+@interface SWRevealTableViewCell(Internal)
+- (void)_getAdjustedRevealPosition:(SWCellRevealPosition*)revealPosition forSymmetry:(int)symmetry;
+- (NSArray*)_getLeftButtonItems;
+- (NSArray*)_getRightButtonItems;
+- (void)_didTapButtonAtIndex:(NSInteger)indx position:(SWCellRevealPosition)position;
+- (BOOL)_isPerformingRevealAnimations;
+- (void)_updateViewForButtonItem:(SWCellButtonItem*)item;
+@end
+
+
+#pragma mark - SWCountedCache
+
+// A NSCache keeping track of the number of objects it holds, so we can report it. Removals and evictions are both
+// reported to the cache delegate, so replaced objects are removed first to keep the count right. NSCache may evict
+// objects from a background thread, so the count is only accessed while holding the lock
+@interface SWCountedCache : NSCache<NSCacheDelegate>
+@property (readonly) NSUInteger count;
+@end
+
+
+@implementation SWCountedCache
+{
+    NSUInteger _count;
+    NSLock *_countLock;
+}
+
+- (id)init
+{
+    self = [super init];
+    if ( self )
+    {
+        _countLock = [[NSLock alloc] init];
+        [self setDelegate:self];
+    }
+    return self;
+}
+
+
+- (NSUInteger)count
+{
+    [_countLock lock];
+    NSUInteger count = _count;
+    [_countLock unlock];
+    return count;
+}
+
+
+- (void)setObject:(id)object forKey:(id)key
+{
+    if ( [self objectForKey:key] )
+        [self removeObjectForKey:key];
+    
+    [_countLock lock];
+    _count += 1;
+    [_countLock unlock];
+    
+    [super setObject:object forKey:key];
+}
+
+
+- (void)cache:(NSCache *)cache willEvictObject:(id)object
+{
+    [_countLock lock];
+    if ( _count > 0 )
+        _count -= 1;
+    [_countLock unlock];
+}
+
 @end
 
+
+#pragma mark - Item image decoding
+
+// Draws the image into a bitmap of at most the given point size, this forces decoding so the result is ready to be rendered.
+// Safe to call from any thread
+static UIImage *_decodedImageWithImage(UIImage *image, CGSize size, CGFloat scale)
+{
+    CGSize imageSize = image.size;
+    if ( imageSize.width <= 0 || imageSize.height <= 0 )
+        return nil;
+    
+    // aspect fit, we never upscale
+    CGFloat ratio = MIN(1, MIN(size.width/imageSize.width, size.height/imageSize.height));
+    CGSize targetSize = CGSizeMake(ceil(imageSize.width*ratio*scale)/scale, ceil(imageSize.height*ratio*scale)/scale);
+    
+    UIGraphicsBeginImageContextWithOptions(targetSize, NO, scale);
+    [image drawInRect:CGRectMake(0, 0, targetSize.width, targetSize.height)];
+    UIImage *decodedImage = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    
+    return [decodedImage imageWithRenderingMode:image.renderingMode];
+}
+
+
+static UIImage *_imageAtURL(NSURL *imageURL)
+{
+    if ( [imageURL isFileURL] )
+        return [UIImage imageWithContentsOfFile:[imageURL path]];
+    
+    NSData *data = [NSData dataWithContentsOfURL:imageURL];
+    return data ? [UIImage imageWithData:data] : nil;
+}
+
+
+static SWCountedCache *_decodedImagesCache(void)
+{
+    static SWCountedCache *cache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        cache = [[SWCountedCache alloc] init];
+        [cache setName:@"SWRevealTableViewCell.decodedImages"];
+    });
+    return cache;
+}
+
+
+static SWCountedCache *_placeholderImagesCache(void)
+{
+    static SWCountedCache *cache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        cache = [[SWCountedCache alloc] init];
+        [cache setName:@"SWRevealTableViewCell.placeholderImages"];
+    });
+    return cache;
+}
+
+
+// Returns a transparent image of the given size for the current screen scale. Images are cached by size,
+// so items created on each data source call do not render a new bitmap
+static UIImage *_cachedPlaceholderImage(CGSize size)
+{
+    if ( size.width <= 0 || size.height <= 0 )
+        return nil;
+    
+    CGFloat scale = [[UIScreen mainScreen] scale];
+    NSString *key = [NSString stringWithFormat:@"%@|%g", NSStringFromCGSize(size), scale];
+    
+    SWCountedCache *cache = _placeholderImagesCache();
+    UIImage *image = [cache objectForKey:key];
+    
+    if ( image == nil )
+    {
+        UIGraphicsBeginImageContextWithOptions(size, NO, scale);
+        image = UIGraphicsGetImageFromCurrentImageContext();
+        UIGraphicsEndImageContext();
+        
+        if ( image )
+            [cache setObject:image forKey:key];
+    }
+    
+    return image;
+}
+
+
+// Items waiting for a decoded image, keyed as the decoded images cache. Only accessed from the main thread,
+// so only one decode is performed for all the items requesting the same image at the same time
+static NSMutableDictionary *_pendingImageItems(void)
+{
+    static NSMutableDictionary *pendingItems = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        pendingItems = [NSMutableDictionary dictionary];
+    });
+    return pendingItems;
+}
+
+
 @implementation SWCellButtonItem
+{
+    NSHashTable *_waitingItems;    // items waiting for the same decoded image, nil if no decode is pending
+}
 
 - (id)initWithImage:(UIImage *)image
 {
@@ -60,19 +274,28 @@
 }
 
 
-//- (id)copyWithZone:(NSZone *)zone
-//{
-//    SWCellButtonItem *theCopy = [[self class] allocWithZone:zone];
-//    theCopy.width = _width;
-//    theCopy.image = _image;
-//    theCopy.backgroundColor = _backgroundColor;
-//    theCopy.tintColor = _tintColor;
-//    theCopy.title = _title;
-//    theCopy.visualEffect = _visualEffect;
-//    theCopy.handler = _handler;
-//    theCopy.view = _view;
-//    return theCopy;
-//}
+// Returns a copy of the receiver with no cell, view or button bound to it. Items cached for a data source signature
+// are never handed to cells, each cell gets its own copies so per cell state is not shared
+- (instancetype)_unboundCopy
+{
+    SWCellButtonItem *theCopy = [[[self class] alloc] initWithTitle:_title image:_image handler:_handler];
+    theCopy->_width = _width;
+    theCopy->_backgroundColor = _backgroundColor;
+    theCopy->_tintColor = _tintColor;
+    theCopy->_visualEffect = _visualEffect;
+    theCopy->_renderingMode = _renderingMode;
+    theCopy->_measuredWidth = _measuredWidth;
+    theCopy->_measuredWidthGeneration = _measuredWidthGeneration;
+    
+    // copies of an item waiting for its image get it too
+    if ( _waitingItems )
+    {
+        theCopy->_waitingItems = _waitingItems;
+        [_waitingItems addObject:theCopy];
+    }
+    
+    return theCopy;
+}
 
 
 - (instancetype)initWithTitle:(NSString *)title image:(UIImage*)image handler:(void(^)(SWCellButtonItem *, SWRevealTableViewCell* cell))handler;
@@ -100,6 +323,116 @@
     return [[SWCellButtonItem alloc] initWithTitle:nil image:image handler:handler];
 }
 
+
++ (instancetype)itemWithImageURL:(NSURL*)imageURL size:(CGSize)size placeholder:(UIImage*)placeholder
+    handler:(void(^)(SWCellButtonItem *item, SWRevealTableViewCell* cell))handler
+{
+    UIImage* (^provider)(void) = ^UIImage*()
+    {
+        return _imageAtURL(imageURL);
+    };
+    
+    return [self itemWithImageProvider:provider identifier:[imageURL absoluteString] size:size placeholder:placeholder handler:handler];
+}
+
+
++ (instancetype)itemWithImageProvider:(UIImage*(^)(void))provider identifier:(id<NSCopying>)identifier size:(CGSize)size
+    placeholder:(UIImage*)placeholder handler:(void(^)(SWCellButtonItem *item, SWRevealTableViewCell* cell))handler
+{
+    // we want an image item from the start, so the view configuration does not change when the actual image arrives
+    if ( placeholder == nil )
+        placeholder = _cachedPlaceholderImage(size);
+    
+    SWCellButtonItem *item = [[SWCellButtonItem alloc] initWithTitle:nil image:placeholder handler:handler];
+    item.width = size.width;
+    
+    [item _loadImageWithProvider:provider identifier:identifier size:size];
+    return item;
+}
+
+
+- (void)_loadImageWithProvider:(UIImage*(^)(void))provider identifier:(id<NSCopying>)identifier size:(CGSize)size
+{
+    CGFloat scale = [[UIScreen mainScreen] scale];
+    NSString *key = identifier ? [NSString stringWithFormat:@"%@|%@|%g", identifier, NSStringFromCGSize(size), scale] : nil;
+    
+    UIImage *cachedImage = key ? [_decodedImagesCache() objectForKey:key] : nil;
+    if ( cachedImage )
+    {
+        self.image = cachedImage;
+        return;
+    }
+    
+    // join an ongoing decode for the same image if there is one
+    NSMutableDictionary *pendingItems = _pendingImageItems();
+    NSHashTable *waitingItems = key ? [pendingItems objectForKey:key] : nil;
+    if ( waitingItems )
+    {
+        _waitingItems = waitingItems;
+        [waitingItems addObject:self];
+        return;
+    }
+    
+    waitingItems = [NSHashTable weakObjectsHashTable];
+    _waitingItems = waitingItems;
+    [waitingItems addObject:self];
+    if ( key ) [pendingItems setObject:waitingItems forKey:key];
+    
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^
+    {
+        UIImage *decodedImage = _decodedImageWithImage(provider(), size, scale);
+        
+        dispatch_async(dispatch_get_main_queue(), ^
+        {
+            if ( key ) [pendingItems removeObjectForKey:key];
+            
+            for ( SWCellButtonItem *item in waitingItems )
+                item->_waitingItems = nil;
+            
+            if ( decodedImage == nil )
+                return;
+            
+            if ( key ) [_decodedImagesCache() setObject:decodedImage forKey:key];
+            
+            for ( SWCellButtonItem *item in waitingItems )
+                [item _setDecodedImage:decodedImage];
+        });
+    });
+}
+
+
+- (void)_setDecodedImage:(UIImage*)image
+{
+    self.image = image;
+    
+    // update the button if we are currently deployed, items rendered using a layer have no button and are updated by the cell
+    if ( _button ) [_button setImage:image forState:UIControlStateNormal];
+    else [_cell _updateViewForButtonItem:self];
+}
+
+
+- (void)_performHandler
+{
+    if ( _handler )
+        _handler( self, _cell );
+}
+
+
+// a measured width is no longer valid if the title or the image change
+
+- (void)setTitle:(NSString *)title
+{
+    _title = title;
+    _measuredWidthGeneration = 0;
+}
+
+
+- (void)setImage:(UIImage *)image
+{
+    _image = image;
+    _measuredWidthGeneration = 0;
+}
+
 // TO DO
 //+ (instancetype)itemWithCustomView:(UIView*)view handler:(void(^)(SWCellButtonItem *item, SWRevealTableViewCell* cell))handler
 //{
@@ -112,6 +445,8 @@
 
 @interface SWUtilityButton : UIButton
 @property (nonatomic) SWCellButtonItem *item;
+@property (nonatomic, weak) SWUtilityContentView *contentView;
+@property (nonatomic, weak) SWRevealTableViewCell *cell;
 @property (nonatomic) BOOL wantsCombinedLayout;
 @end
 
@@ -119,6 +454,25 @@
 
 const CGFloat CombinedHeigh = 36;
 
+- (void)_touchUpAction:(id)sender
+{
+    // items may be shared among cells, so we bind the item to the cell where it was tapped before calling its handler
+    _item.view = _contentView;
+    _item.cell = _cell;
+    _item.button = self;
+    [_item _performHandler];
+}
+
+
++ (instancetype)buttonWithType:(UIButtonType)buttonType
+{
+    SWUtilityButton *button = [super buttonWithType:buttonType];
+    
+    // buttons are reused among cells, so we target the button itself and forward the action to the current item
+    [button addTarget:button action:@selector(_touchUpAction:) forControlEvents:UIControlEventTouchUpInside];
+    return button;
+}
+
 - (CGRect)imageRectForContentRect:(CGRect)contentRect
 {
     CGRect frame = self.bounds;
@@ -153,12 +507,35 @@ const CGFloat CombinedHeigh = 36;
 
 #pragma mark - SWUtilityView
 
+typedef NS_ENUM(NSInteger, SWUtilityViewKind)
+{
+    SWUtilityViewKindTitle = 0,
+    SWUtilityViewKindImage,
+    SWUtilityViewKindCombined,
+    SWUtilityViewKindEffect,
+    SWUtilityViewKindIcon,
+    SWUtilityViewKindCount,
+};
+
+
 @interface SWUtilityView: UIView
 @property ( nonatomic) UIColor *customBackgroundColor;
+@property ( nonatomic) SWUtilityViewKind kind;
+@property ( nonatomic) SWUtilityButton *button;
+@property ( nonatomic) UIView *effectView;
+@property ( nonatomic) BOOL rasterized;
+@property ( nonatomic) BOOL layerBackedLayout;
+@property ( nonatomic) UIImage *iconImage;
+- (void)discardSnapshot;
+- (void)setLayoutFrame:(CGRect)frame;
+- (void)setButtonWidth:(CGFloat)width;
 @end
 
 
 @implementation SWUtilityView
+{
+    UIImage *_snapshotImage;
+}
 
 - (void)setBackgroundColor:(UIColor *)backgroundColor
 {
@@ -177,393 +554,1936 @@ const CGFloat CombinedHeigh = 36;
     return [super backgroundColor];
 }
 
-@end
-
-
-#pragma mark - SWRevealTableViewCell(Internal)
-
-@interface SWRevealTableViewCell(Internal)
-- (void)_getAdjustedRevealPosition:(SWCellRevealPosition*)revealPosition forSymmetry:(int)symmetry;
-- (NSArray*)_getLeftButtonItems;
-- (NSArray*)_getRightButtonItems;
-- (void)_didTapButtonAtIndex:(NSInteger)indx position:(SWCellRevealPosition)position;
-@end
-
-
-#pragma mark - SWUtilityContentView
 
-@interface SWUtilityContentView: SWUtilityView
+// While rasterized, the button is hidden and its snapshot is shown as our layer contents. The contents gravity keeps the
+// snapshot pinned to the same edge as the button autoresizing would, and our clipping bounds do the rest, so changing our
+// frame does not cause any button layout
+- (void)setRasterized:(BOOL)rasterized
 {
-    __weak SWRevealTableViewCell *_c;
+    if ( _rasterized == rasterized )
+        return;
+    
+    // visual effects can not be rendered to a bitmap, icons already are one
+    if ( rasterized && (_kind == SWUtilityViewKindEffect || _kind == SWUtilityViewKindIcon) )
+        return;
+    
+    _rasterized = rasterized;
+    
+    CALayer *layer = self.layer;
+    BOOL pinnedRight = [self _buttonIsPinnedRight];
+    
+    if ( rasterized )
+    {
+        UIImage *image = [self _buttonSnapshotImage];
+        [layer setContents:(id)image.CGImage];
+        [layer setContentsScale:image.scale];
+        [layer setContentsGravity:pinnedRight ? kCAGravityRight : kCAGravityLeft];
+        [self setAutoresizesSubviews:NO];
+        [_button setHidden:YES];
+    }
+    else
+    {
+        [layer setContents:nil];
+        [self setAutoresizesSubviews:!_layerBackedLayout];
+        [self _layoutSubviewsForCurrentBounds];
+        [_button setHidden:NO];
+    }
 }
 
-@property (nonatomic,readonly) NSArray *leftButtonItems;
-@property (nonatomic,readonly) NSArray *rightButtonItems;
-@property (nonatomic,readonly) NSMutableArray *leftViews;
-@property (nonatomic,readonly) NSMutableArray *rightViews;
 
-@end
+- (BOOL)_buttonIsPinnedRight
+{
+    return (_button.autoresizingMask & UIViewAutoresizingFlexibleLeftMargin) != 0;
+}
 
 
-static UIImage* _imageWithColor_size(UIColor* color, CGSize size)
+// Gets the button and effect view to where autoresizing would have placed them. For layer backed layout they keep their full
+// width at our bounds origin, and our bounds origin gets shifted instead for right pinned buttons, see setLayoutFrame:
+- (void)_layoutSubviewsForCurrentBounds
 {
-    CGFloat scale = [[UIScreen mainScreen] scale];
-    CGRect rect = CGRectMake(0.0f, 0.0f, scale*size.width, scale*size.height);
-    
-    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-    CGContextRef context = CGBitmapContextCreate(NULL, rect.size.width, rect.size.height, 8, 0, colorSpace, (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
-    CGColorSpaceRelease(colorSpace);
-    
-    if (context == NULL)
-        return nil;
+    CGRect bounds = self.bounds;
+    CGRect frame = _button.frame;
     
-    CGContextSetFillColorWithColor(context, [color CGColor]); // <-- Color to fill
-    CGContextFillRect(context, rect);
+    frame.origin.x = _layerBackedLayout ? 0 : ([self _buttonIsPinnedRight] ? bounds.size.width-frame.size.width : 0);
+    frame.origin.y = 0;
+    frame.size.height = bounds.size.height;
+    [_button setFrame:frame];
     
-    CGImageRef bitmapContext = CGBitmapContextCreateImage(context);
-    CGContextRelease(context);
+    if ( _effectView )
+        [_effectView setFrame:_layerBackedLayout ? CGRectMake(0, 0, frame.size.width, frame.size.height) : CGRectMake(0, 0, bounds.size.width, bounds.size.height)];
+}
+
+
+- (void)setLayerBackedLayout:(BOOL)layerBackedLayout
+{
+    if ( _layerBackedLayout == layerBackedLayout )
+        return;
     
-    UIImage *theImage = [UIImage imageWithCGImage:bitmapContext scale:scale orientation:UIImageOrientationUp];
-    CGImageRelease(bitmapContext);
+    _layerBackedLayout = layerBackedLayout;
     
-    return theImage;
+    // autoresizing is replaced by our own layout, and our bounds origin is only ever shifted for layer backed layout
+    CGRect bounds = self.bounds;
+    bounds.origin = CGPointZero;
+    [self setBounds:bounds];
+    [self setAutoresizesSubviews:!(layerBackedLayout || _rasterized)];
+    [self _layoutSubviewsForCurrentBounds];
 }
 
 
-@implementation SWUtilityContentView
-
-- (id)initWithRevealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell frame:(CGRect)frame
+// Sets the frame of the receiver. For layer backed layout, the layer position and bounds are set directly, so no UIView layout
+// or autoresizing is involved. A right pinned button is kept in place by shifting the bounds origin rather than moving the button
+- (void)setLayoutFrame:(CGRect)frame
 {
-    self = [super initWithFrame:frame];
-    if ( self )
+    if ( !_layerBackedLayout )
     {
-        [self setAutoresizesSubviews:NO];
-        _c = revealTableViewCell;
+        [self setFrame:frame];
+        return;
     }
-    return self;
+    
+    CALayer *layer = self.layer;
+    CGFloat fullWidth = _button.bounds.size.width;
+    CGFloat xOrigin = [self _buttonIsPinnedRight] ? fullWidth-frame.size.width : 0;
+    CGPoint anchor = layer.anchorPoint;
+    
+    [layer setBounds:CGRectMake(xOrigin, 0, frame.size.width, frame.size.height)];
+    [layer setPosition:CGPointMake(frame.origin.x + anchor.x*frame.size.width, frame.origin.y + anchor.y*frame.size.height)];
+    
+    // buttons only need to be laid out again if the cell height changed
+    if ( _button && _button.bounds.size.height != frame.size.height )
+        [self _layoutSubviewsForCurrentBounds];
 }
 
 
-- (NSInteger)leftCount
+// The snapshot is kept until the view gets back to the pool, so it is rendered only once for a given button size
+- (UIImage*)_buttonSnapshotImage
 {
-
-    [self _prepareLeftButtonItems];
-    return _leftButtonItems.count;
+    CGSize size = _button.bounds.size;
+    if ( _snapshotImage && CGSizeEqualToSize(_snapshotImage.size, size) )
+        return _snapshotImage;
+    
+    _snapshotImage = nil;
+    if ( size.width <= 0 || size.height <= 0 )
+        return nil;
+    
+    [_button layoutIfNeeded];
+    UIGraphicsBeginImageContextWithOptions(size, NO, 0);
+    [_button.layer renderInContext:UIGraphicsGetCurrentContext()];
+    _snapshotImage = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    
+    return _snapshotImage;
 }
 
 
-- (NSInteger)rightCount
+- (void)discardSnapshot
 {
-    [self _prepareRightButtonItems];
-    return _rightButtonItems.count;
+    [self setRasterized:NO];
+    _snapshotImage = nil;
+}
+
+
+// Icon views have no button, the image is shown as our layer contents, centered on the visible part of the item
+- (void)setIconImage:(UIImage *)iconImage
+{
+    if ( _iconImage == iconImage )
+        return;
+    
+    _iconImage = iconImage;
+    
+    CALayer *layer = self.layer;
+    [layer setContents:(id)iconImage.CGImage];
+    [layer setContentsScale:iconImage ? iconImage.scale : 1];
+}
+
+
+// Changes the button width of a deployed view without touching our own frame, which keeps being set by the item layout
+- (void)setButtonWidth:(CGFloat)width
+{
+    CGRect frame = _button.frame;
+    frame.size.width = width;
+    [_button setFrame:frame];
+    [self _layoutSubviewsForCurrentBounds];
+}
+
+@end
+
+
+#pragma mark - SWUtilityViewPool
+
+static SWUtilityViewKind _utilityViewKindForItem(SWCellButtonItem *item)
+{
+#if SupportsVisualEffects
+    if ( item.visualEffect )
+        return SWUtilityViewKindEffect;
+#endif
+    
+    if ( item.image && item.title.length==0 && item.renderingMode == SWCellButtonItemRenderingModeLayer )
+        return SWUtilityViewKindIcon;
+    
+    if ( item.image && item.title.length>0 )
+        return SWUtilityViewKindCombined;
+    
+    if ( item.image )
+        return SWUtilityViewKindImage;
+    
+    return SWUtilityViewKindTitle;
+}
+
+
+// The font set on the buttons of each kind of utility view, also used to measure automatic widths
+static UIFont *_titleFontForUtilityViewKind(SWUtilityViewKind kind)
+{
+    if ( kind == SWUtilityViewKindCombined )
+        return [UIFont preferredFontForTextStyle:UIFontTextStyleFootnote];
+    
+    return [UIFont systemFontOfSize:15];
+}
+
+
+#pragma mark - Automatic widths
+
+const CGFloat AutomaticWidthMargin = 15;
+
+// Measured widths are valid for the current generation, which is advanced when the content size category changes
+static NSUInteger _measuredWidthGeneration = 1;
+
+static NSCache *_measuredWidthsCache(void)
+{
+    static NSCache *cache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        cache = [[NSCache alloc] init];
+        [cache setName:@"SWRevealTableViewCell.measuredWidths"];
+        
+        [[NSNotificationCenter defaultCenter] addObserverForName:UIContentSizeCategoryDidChangeNotification object:nil
+            queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *note)
+        {
+            [cache removeAllObjects];
+            _measuredWidthGeneration += 1;
+        }];
+    });
+    return cache;
+}
+
+
+static CGFloat _measureItemWidth(SWCellButtonItem *item)
+{
+    SWUtilityViewKind kind = _utilityViewKindForItem(item);
+    NSString *title = item.title;
+    UIImage *image = item.image;
+    CGSize imageSize = image.size;
+    
+    // measurements are shared among all items with the same title and image size and scale, for the current content size category
+    NSString *key = [NSString stringWithFormat:@"%ld|%@|%g|%@", (long)kind, NSStringFromCGSize(imageSize), image?image.scale:0, title?title:@""];
+    NSCache *cache = _measuredWidthsCache();
+    
+    NSNumber *width = [cache objectForKey:key];
+    if ( width == nil )
+    {
+        CGFloat titleWidth = 0;
+        if ( title.length > 0 )
+        {
+            NSDictionary *attributes = @{NSFontAttributeName:_titleFontForUtilityViewKind(kind)};
+            CGRect rect = [title boundingRectWithSize:CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX)
+                options:NSStringDrawingUsesLineFragmentOrigin attributes:attributes context:nil];
+            titleWidth = rect.size.width;
+        }
+        
+        width = @( ceil(MAX(titleWidth, imageSize.width)) + 2*AutomaticWidthMargin );
+        [cache setObject:width forKey:key];
+    }
+    
+    return [width floatValue];
+}
+
+
+// Returns the width an item is actually laid out with, automatic widths are measured once and remembered by the item
+static CGFloat _resolvedItemWidth(SWCellButtonItem *item)
+{
+    CGFloat width = item.width;
+    if ( width != SWCellButtonItemAutomaticWidth )
+        return width;
+    
+    // make sure the cache is set up so the generation gets advanced on content size category changes
+    _measuredWidthsCache();
+    
+    if ( item.measuredWidthGeneration != _measuredWidthGeneration )
+    {
+        item.measuredWidth = _measureItemWidth(item);
+        item.measuredWidthGeneration = _measuredWidthGeneration;
+    }
+    
+    return item.measuredWidth;
+}
+
+
+@interface SWUtilityViewPool()
+- (SWUtilityView*)_dequeueUtilityViewOfKind:(SWUtilityViewKind)kind;
+- (void)_enqueueUtilityView:(SWUtilityView*)utilityView;
+@end
+
+
+// All the pools in use, so their idle views can be accounted for
+static NSHashTable *_allUtilityViewPools(void)
+{
+    static NSHashTable *pools = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        pools = [NSHashTable weakObjectsHashTable];
+    });
+    return pools;
+}
+
+
+@implementation SWUtilityViewPool
+{
+    NSArray *_views;   // one mutable array of idle views for each SWUtilityViewKind
+}
+
+
++ (instancetype)sharedPool
+{
+    static SWUtilityViewPool *sharedPool = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        sharedPool = [[SWUtilityViewPool alloc] init];
+    });
+    return sharedPool;
+}
+
+
+- (id)init
+{
+    self = [super init];
+    if ( self )
+    {
+        NSMutableArray *views = [NSMutableArray array];
+        for ( NSInteger kind=0 ; kind<SWUtilityViewKindCount ; kind++ )
+            [views addObject:[NSMutableArray array]];
+        
+        _views = [views copy];
+        _maximumPooledViewCount = 16;
+        [_allUtilityViewPools() addObject:self];
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(_didReceiveMemoryWarning:)
+            name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+        
+        // pooled views got their fonts for the previous content size category
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(_contentSizeCategoryDidChange:)
+            name:UIContentSizeCategoryDidChangeNotification object:nil];
+    }
+    return self;
+}
+
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+
+- (void)setMaximumPooledViewCount:(NSUInteger)maximumPooledViewCount
+{
+    _maximumPooledViewCount = maximumPooledViewCount;
+    for ( NSMutableArray *views in _views )
+    {
+        if ( views.count > maximumPooledViewCount )
+            [views removeObjectsInRange:NSMakeRange(maximumPooledViewCount, views.count-maximumPooledViewCount)];
+    }
+}
+
+
+- (void)purge
+{
+    for ( NSMutableArray *views in _views )
+        [views removeAllObjects];
+}
+
+
+- (NSUInteger)pooledViewCount
+{
+    NSUInteger count = 0;
+    for ( NSMutableArray *views in _views )
+        count += views.count;
+    
+    return count;
+}
+
+
+- (void)_didReceiveMemoryWarning:(NSNotification*)notification
+{
+    [self purge];
+}
+
+
+- (void)_contentSizeCategoryDidChange:(NSNotification*)notification
+{
+    [self purge];
+}
+
+
+- (SWUtilityView*)_dequeueUtilityViewOfKind:(SWUtilityViewKind)kind
+{
+    NSMutableArray *views = [_views objectAtIndex:kind];
+    SWUtilityView *utilityView = [views lastObject];
+    
+    if ( utilityView )
+    {
+        [views removeLastObject];
+        return utilityView;
+    }
+    
+    return [self _newUtilityViewOfKind:kind];
+}
+
+
+- (void)_enqueueUtilityView:(SWUtilityView*)utilityView
+{
+    SWUtilityButton *button = utilityView.button;
+    SWCellButtonItem *item = button.item;
+    
+    // detach the view from its item, we do not want items to point to a button that will be reused elsewhere
+    if ( item.button == button )
+        item.button = nil;
+    
+    [button setItem:nil];
+    [button setContentView:nil];
+    [button setCell:nil];
+    [button setTitle:nil forState:UIControlStateNormal];
+    [button setImage:nil forState:UIControlStateNormal];
+    [utilityView setCustomBackgroundColor:nil];
+    [utilityView setIconImage:nil];
+    [utilityView discardSnapshot];
+    [utilityView setLayerBackedLayout:NO];
+    [utilityView setHidden:NO];
+    [utilityView setAlpha:1];
+    [utilityView removeFromSuperview];
+    
+    NSMutableArray *views = [_views objectAtIndex:utilityView.kind];
+    if ( views.count < _maximumPooledViewCount )
+        [views addObject:utilityView];
+}
+
+
+// Creates a utility view with the configuration that does not depend on particular item values
+- (SWUtilityView*)_newUtilityViewOfKind:(SWUtilityViewKind)kind
+{
+    SWUtilityView *utilityView = [[SWUtilityView alloc] initWithFrame:CGRectMake(0, 0, 20, 20)];
+    [utilityView setClipsToBounds:YES];
+    [utilityView setKind:kind];
+    
+    // icons are just our own layer, taps on them are handled by the content view
+    if ( kind == SWUtilityViewKindIcon )
+    {
+        [utilityView setUserInteractionEnabled:NO];
+        [utilityView.layer setContentsGravity:kCAGravityCenter];
+        return utilityView;
+    }
+    
+#if SupportsVisualEffects
+    // add a visual effect view, the actual effect is set on deployment
+    if ( kind == SWUtilityViewKindEffect )
+    {
+        UIVisualEffectView *effectView = [[UIVisualEffectView alloc] initWithEffect:nil];
+        effectView.autoresizingMask = UIViewAutoresizingFlexibleHeight|UIViewAutoresizingFlexibleWidth;
+        effectView.frame = utilityView.bounds;
+        [utilityView addSubview:effectView];
+        [utilityView setEffectView:effectView];
+    }
+#endif
+    
+    // add a button
+    SWUtilityButton *button = [SWUtilityButton buttonWithType:UIButtonTypeSystem];
+    button.frame = utilityView.bounds;
+    button.titleLabel.numberOfLines = 0;
+    button.titleLabel.textAlignment = NSTextAlignmentCenter;
+    
+    if ( kind == SWUtilityViewKindTitle )
+    {
+        // title only items may get a solid color image, we want it to fill the button
+        [button.imageView setContentMode:UIViewContentModeScaleToFill];
+    }
+    else
+    {
+        // we do not want to scale user provided images
+        [button.imageView setContentMode:UIViewContentModeCenter];
+    }
+    
+    [button.titleLabel setFont:_titleFontForUtilityViewKind(kind)];
+    
+    if ( kind == SWUtilityViewKindCombined )
+    {
+        [button setWantsCombinedLayout:YES];
+    }
+    
+    [utilityView addSubview:button];
+    [utilityView setButton:button];
+    
+    return utilityView;
+}
+
+@end
+
+
+#pragma mark - SWItemOffsets
+
+// Cascade layout coefficients of an item. For a reveal progress t from 0 to 1 the item frame is given by
+// x = floor(xReference + xSlope*t) and w = ceil(widthSlope*t), where xReference is 0 for left items and the bounds width for right items.
+// This does not depend on the cascade direction, which only determines the stacking order of views
+typedef struct
+{
+    CGFloat xSlope;
+    CGFloat widthSlope;
+} SWItemLayout;
+
+
+// Prefix sums of the item widths on one side of a SWUtilityContentView, along with their layout coefficients
+typedef struct
+{
+    NSInteger count;
+    CGFloat *offsets;       // count+1 values, offsets[i] is the sum of the widths of items before i, offsets[count] is the total width
+    SWItemLayout *layout;   // count values, stored in the same block as offsets
+    CGRect *frames;         // count values, scratch space for custom layout strategies, stored in the same block as offsets
+} SWItemOffsets;
+
+
+// The symmetry is 1 for left items and -1 for right items
+static SWItemOffsets _itemOffsetsForItems(NSArray *items, CGFloat symmetry)
+{
+    SWItemOffsets itemOffsets = { 0, NULL, NULL, NULL };
+    NSInteger count = items.count;
+    
+    if ( count == 0 )
+        return itemOffsets;
+    
+    itemOffsets.count = count;
+    itemOffsets.offsets = malloc( (count+1)*sizeof(CGFloat) + count*sizeof(SWItemLayout) + count*sizeof(CGRect) );
+    itemOffsets.layout = (SWItemLayout*)(itemOffsets.offsets + count+1);
+    itemOffsets.frames = (CGRect*)(itemOffsets.layout + count);
+    itemOffsets.offsets[0] = 0;
+    
+    NSInteger i = 0;
+    for ( SWCellButtonItem *item in items )
+    {
+        // we also keep the item index, so getting back to its offset is a direct lookup
+        item.index = i;
+        itemOffsets.offsets[i+1] = itemOffsets.offsets[i] + _resolvedItemWidth(item);
+        i++;
+    }
+    
+    // left items start at their own offset, right items grow leftwards from the right edge
+    for ( i=0 ; i<count ; i++ )
+    {
+        itemOffsets.layout[i].xSlope = symmetry>0 ? itemOffsets.offsets[i] : -itemOffsets.offsets[i+1];
+        itemOffsets.layout[i].widthSlope = itemOffsets.offsets[i+1] - itemOffsets.offsets[i];
+    }
+    
+    return itemOffsets;
+}
+
+
+static void _releaseItemOffsets(SWItemOffsets *itemOffsets)
+{
+    free( itemOffsets->offsets );
+    itemOffsets->offsets = NULL;
+    itemOffsets->layout = NULL;
+    itemOffsets->frames = NULL;
+    itemOffsets->count = 0;
+}
+
+
+static inline CGFloat _itemOffsetsTotalWidth(SWItemOffsets itemOffsets)
+{
+    return itemOffsets.count > 0 ? itemOffsets.offsets[itemOffsets.count] : 0;
+}
+
+
+#pragma mark - SWRevealLayout
+
+// Frame of an item for a built in layout style, see SWItemLayout. The symmetry is 1 for left items and -1 for right items
+static inline CGRect _builtInItemFrame(SWRevealLayoutStyle style, SWItemLayout layout, CGFloat xReference, CGFloat symmetry,
+    CGFloat revealWidth, CGFloat progress, CGFloat height)
+{
+    CGFloat t = style == SWRevealLayoutStyleStretch ? progress : MIN(progress, 1);
+    CGFloat x, w;
+    
+    switch ( style )
+    {
+        case SWRevealLayoutStyleFixed:
+            x = xReference + layout.xSlope;
+            w = layout.widthSlope;
+            break;
+            
+        case SWRevealLayoutStyleParallax:
+            x = floor(xReference + layout.xSlope - symmetry*(1-t)*revealWidth*0.5f);
+            w = layout.widthSlope;
+            break;
+            
+        default:
+// This works better on iOS8
+//            x = 0.5*floor(2*(xReference + layout.xSlope*t));
+//            w = 0.5*ceil(2*layout.widthSlope*t);
+        
+// This works better on iOS7
+            x = floor(xReference + layout.xSlope*t);
+            w = ceil(layout.widthSlope*t);
+            break;
+    }
+    
+    return CGRectMake(x, 0, w, height);
+}
+
+
+@implementation SWRevealLayout
+
++ (instancetype)layoutWithStyle:(SWRevealLayoutStyle)style
+{
+    SWRevealLayout *layout = [[SWRevealLayout alloc] init];
+    layout->_style = style;
+    return layout;
+}
+
+
+// Cells perform built in layouts inline, this is only called when the receiver is used from elsewhere
+- (void)revealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell getFrames:(CGRect *)frames forItemOffsets:(const CGFloat *)offsets
+    count:(NSInteger)count leftSide:(BOOL)leftSide progress:(CGFloat)progress bounds:(CGRect)bounds
+{
+    CGFloat symmetry = leftSide ? 1 : -1;
+    CGFloat xReference = leftSide ? CGRectGetMinX(bounds) : CGRectGetMaxX(bounds);
+    CGFloat revealWidth = count > 0 ? offsets[count] : 0;
+    
+    for ( NSInteger i=0 ; i<count ; i++ )
+    {
+        SWItemLayout layout = { leftSide ? offsets[i] : -offsets[i+1], offsets[i+1] - offsets[i] };
+        frames[i] = _builtInItemFrame(_style, layout, xReference, symmetry, revealWidth, progress, bounds.size.height);
+    }
+}
+
+
+- (CGFloat)overdrawDamperWidth
+{
+    return _style == SWRevealLayoutStyleStretch ? 160 : 80;
+}
+
+@end
+
+
+#pragma mark - SWUtilityContentView
+
+typedef void (*SWRevealLayoutFunction)(id, SEL, SWRevealTableViewCell*, CGRect*, const CGFloat*, NSInteger, BOOL, CGFloat, CGRect);
+
+@interface SWUtilityContentView: SWUtilityView<UIGestureRecognizerDelegate>
+{
+    __weak SWRevealTableViewCell *_c;
+    UITapGestureRecognizer *_iconTapGestureRecognizer;
+    SWItemOffsets _leftOffsets;
+    SWItemOffsets _rightOffsets;
+    BOOL _leftViewsPrewarmed;
+    BOOL _rightViewsPrewarmed;
+    SWRevealLayoutStyle _layoutStyle;
+    SWRevealLayoutFunction _layoutFunction;
+}
+
+@property (nonatomic,readonly) SWRevealTableViewCell *revealTableViewCell;
+@property (nonatomic) id <SWRevealLayoutStrategy> layoutStrategy;
+@property (nonatomic) BOOL rasterizesItems;
+@property (nonatomic) BOOL layerBacksItems;
+@property (nonatomic,readonly) NSArray *leftButtonItems;
+@property (nonatomic,readonly) NSArray *rightButtonItems;
+@property (nonatomic,readonly) NSMutableArray *leftViews;
+@property (nonatomic,readonly) NSMutableArray *rightViews;
+
+- (void)reloadLeftItems:(NSArray*)leftItems rightItems:(NSArray*)rightItems location:(CGFloat)xLocation
+    insertedViews:(NSMutableArray*)insertedViews removedViews:(NSMutableArray*)removedViews;
+- (void)updateViewForItem:(SWCellButtonItem*)item;
+- (void)getItemCount:(NSUInteger*)itemCount utilityViewCount:(NSUInteger*)utilityViewCount;
+
+@end
+
+
+static UIImage* _imageWithColor_size(UIColor* color, CGSize size)
+{
+    CGFloat scale = [[UIScreen mainScreen] scale];
+    CGRect rect = CGRectMake(0.0f, 0.0f, scale*size.width, scale*size.height);
+    
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, rect.size.width, rect.size.height, 8, 0, colorSpace, (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(colorSpace);
+    
+    if (context == NULL)
+        return nil;
+    
+    CGContextSetFillColorWithColor(context, [color CGColor]); // <-- Color to fill
+    CGContextFillRect(context, rect);
+    
+    CGImageRef bitmapContext = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    
+    UIImage *theImage = [UIImage imageWithCGImage:bitmapContext scale:scale orientation:UIImageOrientationUp];
+    CGImageRelease(bitmapContext);
+    
+    return theImage;
+}
+
+
+static SWCountedCache *_colorImagesCache(void)
+{
+    static SWCountedCache *imageCache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        imageCache = [[SWCountedCache alloc] init];
+        [imageCache setName:@"SWRevealTableViewCell.colorImages"];
+    });
+    return imageCache;
+}
+
+
+// Returns a 1x1 point image of the given color ready to be set on a button. Images are cached process wide
+// by color, so only the first request for a particular color creates a bitmap. NSCache takes care of
+// evicting unused images on memory pressure
+static UIImage* _cachedImageWithColor(UIColor* color)
+{
+    SWCountedCache *imageCache = _colorImagesCache();
+    
+    // cached images are only valid for the current screen scale
+    CGFloat scale = [[UIScreen mainScreen] scale];
+    UIImage *image = [imageCache objectForKey:color];
+    
+    if ( image == nil || image.scale != scale )
+    {
+        image = _imageWithColor_size(color, CGSizeMake(1,1));
+        image = [image imageWithRenderingMode:UIImageRenderingModeAlwaysOriginal];
+        
+        if ( image )
+            [imageCache setObject:image forKey:color];
+    }
+    
+    return image;
+}
+
+
+// Key for tinted images, images are compared by identity and colors by value
+@interface SWTintedImageKey : NSObject<NSCopying>
+@property (nonatomic, readonly) UIImage *image;
+@property (nonatomic, readonly) UIColor *tintColor;
+@end
+
+
+@implementation SWTintedImageKey
+
++ (instancetype)keyWithImage:(UIImage*)image tintColor:(UIColor*)tintColor
+{
+    SWTintedImageKey *key = [[SWTintedImageKey alloc] init];
+    key->_image = image;
+    key->_tintColor = tintColor;
+    return key;
+}
+
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return self;
+}
+
+
+- (NSUInteger)hash
+{
+    return (NSUInteger)(__bridge void*)_image ^ [_tintColor hash];
+}
+
+
+- (BOOL)isEqual:(id)object
+{
+    if ( ![object isKindOfClass:[SWTintedImageKey class]] )
+        return NO;
+    
+    SWTintedImageKey *key = object;
+    return _image == key->_image && [_tintColor isEqual:key->_tintColor];
+}
+
+@end
+
+
+static SWCountedCache *_tintedImagesCache(void)
+{
+    static SWCountedCache *imageCache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        imageCache = [[SWCountedCache alloc] init];
+        [imageCache setName:@"SWRevealTableViewCell.tintedImages"];
+    });
+    return imageCache;
+}
+
+
+// Returns the image as it would be rendered by a system button with the given tint color, that is the tint color masked by the
+// image alpha, unless the image is meant to be rendered as original. Tinted images are cached by image and tint color,
+// so icon items sharing an image and a tint color are only rendered once. NSCache evicts them on memory pressure
+static UIImage* _cachedTintedImage(UIImage* image, UIColor* tintColor)
+{
+    if ( image == nil || tintColor == nil || image.renderingMode == UIImageRenderingModeAlwaysOriginal )
+        return image;
+    
+    SWCountedCache *imageCache = _tintedImagesCache();
+    SWTintedImageKey *key = [SWTintedImageKey keyWithImage:image tintColor:tintColor];
+    UIImage *tintedImage = [imageCache objectForKey:key];
+    
+    if ( tintedImage == nil )
+    {
+        CGRect rect = CGRectMake(0, 0, image.size.width, image.size.height);
+        UIGraphicsBeginImageContextWithOptions(rect.size, NO, image.scale);
+        [tintColor setFill];
+        UIRectFill(rect);
+        [image drawInRect:rect blendMode:kCGBlendModeDestinationIn alpha:1];
+        tintedImage = UIGraphicsGetImageFromCurrentImageContext();
+        UIGraphicsEndImageContext();
+        
+        if ( tintedImage == nil )
+            return image;
+        
+        [imageCache setObject:tintedImage forKey:key];
+    }
+    
+    return tintedImage;
+}
+
+
+// All the utility content views alive, that is one for every cell that got into a window. We use this to account for resources
+// held by cells, and to release them on memory warnings
+static NSHashTable *_allUtilityContentViews(void)
+{
+    static NSHashTable *contentViews = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        contentViews = [NSHashTable weakObjectsHashTable];
+        
+        [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification object:nil
+            queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *note)
+        {
+            [SWRevealTableViewCell releaseAllIdleResources];
+        }];
+    });
+    return contentViews;
+}
+
+
+@implementation SWUtilityContentView
+
+- (id)initWithRevealTableViewCell:(SWRevealTableViewCell *)revealTableViewCell frame:(CGRect)frame
+{
+    self = [super initWithFrame:frame];
+    if ( self )
+    {
+        [self setAutoresizesSubviews:NO];
+        _c = revealTableViewCell;
+        [_allUtilityContentViews() addObject:self];
+        
+        // a single recognizer handles taps on all the icon items of both sides, see gestureRecognizer:shouldReceiveTouch:
+        _iconTapGestureRecognizer = [[UITapGestureRecognizer alloc] initWithTarget:self action:@selector(_handleIconTap:)];
+        _iconTapGestureRecognizer.delegate = self;
+        [self addGestureRecognizer:_iconTapGestureRecognizer];
+    }
+    return self;
+}
+
+
+- (void)dealloc
+{
+    _releaseItemOffsets( &_leftOffsets );
+    _releaseItemOffsets( &_rightOffsets );
+}
+
+
+- (SWRevealTableViewCell*)revealTableViewCell
+{
+    return _c;
+}
+
+
+- (void)getItemCount:(NSUInteger*)itemCount utilityViewCount:(NSUInteger*)utilityViewCount
+{
+    *itemCount = _leftButtonItems.count + _rightButtonItems.count;
+    *utilityViewCount = _leftViews.count + _rightViews.count;
+}
+
+
+- (NSInteger)leftCount
+{
+
+    [self _prepareLeftButtonItems];
+    return _leftButtonItems.count;
+}
+
+
+- (NSInteger)rightCount
+{
+    [self _prepareRightButtonItems];
+    return _rightButtonItems.count;
 }
 
 
 - (CGFloat)leftRevealWidth
 {
-    CGFloat width = 0;
-    for ( SWCellButtonItem *item in _leftButtonItems )
+    return _itemOffsetsTotalWidth(_leftOffsets);
+}
+
+
+- (CGFloat)rightRevealWidth
+{
+    return _itemOffsetsTotalWidth(_rightOffsets);
+}
+
+
+- (CGRect)referenceFrameForCellButtonItem:(SWCellButtonItem*)targetItem
+{
+    CGRect bounds = self.bounds;
+    NSInteger index = targetItem.index;
+    
+    CGFloat location = bounds.origin.x + _itemOffsetsTotalWidth(_leftOffsets);
+    CGFloat width = 0;
+    
+    // right items are placed from the right edge, left items from the left edge
+    if ( index < _rightOffsets.count && [_rightButtonItems objectAtIndex:index] == targetItem )
+    {
+        location = bounds.size.width - _rightOffsets.offsets[index+1];
+        width = _rightOffsets.offsets[index+1] - _rightOffsets.offsets[index];
+    }
+    
+    else if ( index < _leftOffsets.count && [_leftButtonItems objectAtIndex:index] == targetItem )
+    {
+        location = bounds.origin.x + _leftOffsets.offsets[index];
+        width = _leftOffsets.offsets[index+1] - _leftOffsets.offsets[index];
+    }
+
+    CGRect referenceFrame = bounds;
+    referenceFrame.origin.x = location;
+    referenceFrame.size.width = width;
+
+    return referenceFrame;
+}
+
+
+- (void)deployRightItems
+{
+    SWSignpostBegin("DeployItems");
+    [self _deployItemsForNewPosition:SWCellRevealPositionRight];
+    SWSignpostEnd("DeployItems");
+}
+
+
+- (void)undeployRightItems
+{
+    [self _undeployItemsForNewPosition:SWCellRevealPositionRight];
+}
+
+
+- (void)deployLeftItems
+{
+    SWSignpostBegin("DeployItems");
+    [self _deployItemsForNewPosition:SWCellRevealPositionLeft];
+    SWSignpostEnd("DeployItems");
+}
+
+
+- (void)undeployLeftItems
+{
+    [self _undeployItemsForNewPosition:SWCellRevealPositionLeft];
+}
+
+
+- (CGFloat)frontLocationForPosition:(SWCellRevealPosition)revealPosition
+{
+    int symmetry = revealPosition<SWCellRevealPositionCenter? -1 : 1;
+    
+    CGFloat location = 0.0f;
+    CGFloat itemsWidth = revealPosition<SWCellRevealPositionCenter? [self rightRevealWidth] : [self leftRevealWidth];
+    
+    [_c _getAdjustedRevealPosition:&revealPosition forSymmetry:symmetry];
+    
+    if ( revealPosition == SWCellRevealPositionRight )
+        location = itemsWidth;
+    
+    else if ( revealPosition > SWCellRevealPositionRight )
+        location = itemsWidth;
+
+    return location*symmetry;
+}
+
+
+- (void)layoutForLocation:(CGFloat)xLocation
+{
+    // layer backed layout updates all items in a single transaction. Actions are only disabled out of reveal animations,
+    // as UIView animations rely on them to animate our layers
+    BOOL disablesActions = _layerBacksItems && ![_c _isPerformingRevealAnimations];
+    if ( disablesActions )
+    {
+        [CATransaction begin];
+        [CATransaction setDisableActions:YES];
+    }
+    
+    if ( xLocation <= 0 )
+    {
+        [self _layoutViewsForNewPosition:SWCellRevealPositionRight location:xLocation filter:nil];
+    }
+    
+    if ( xLocation >= 0 )
+    {
+        [self _layoutViewsForNewPosition:SWCellRevealPositionLeft location:xLocation filter:nil];
+    }
+    
+    if ( disablesActions )
+    {
+        [CATransaction commit];
+    }
+}
+
+
+- (void)setLayerBacksItems:(BOOL)layerBacksItems
+{
+    _layerBacksItems = layerBacksItems;
+    
+    for ( SWUtilityView *utilityView in _leftViews ) [utilityView setLayerBackedLayout:layerBacksItems];
+    for ( SWUtilityView *utilityView in _rightViews ) [utilityView setLayerBackedLayout:layerBacksItems];
+}
+
+
+- (void)prewarmItems
+{
+    [self _prepareLeftButtonItems];
+    [self _prepareRightButtonItems];
+    
+    // deploy hidden views for the sides that are not deployed yet, they will just be shown on actual deployment
+    if ( _leftViews == nil )
+    {
+        [self _deployItemsForNewPosition:SWCellRevealPositionLeft];
+        for ( SWUtilityView *utilityView in _leftViews ) [utilityView setHidden:YES];
+        _leftViewsPrewarmed = (_leftViews != nil);
+    }
+    
+    if ( _rightViews == nil )
+    {
+        [self _deployItemsForNewPosition:SWCellRevealPositionRight];
+        for ( SWUtilityView *utilityView in _rightViews ) [utilityView setHidden:YES];
+        _rightViewsPrewarmed = (_rightViews != nil);
+    }
+}
+
+
+- (void)setRasterizesItems:(BOOL)rasterizesItems
+{
+    if ( _rasterizesItems == rasterizesItems )
+        return;
+    
+    _rasterizesItems = rasterizesItems;
+    
+    for ( SWUtilityView *utilityView in _leftViews ) [utilityView setRasterized:rasterizesItems];
+    for ( SWUtilityView *utilityView in _rightViews ) [utilityView setRasterized:rasterizesItems];
+}
+
+
+- (void)resetButtonItems
+{
+    // prewarmed views were deployed for the items we are about to discard
+    if ( _leftViewsPrewarmed ) [self undeployLeftItems];
+    if ( _rightViewsPrewarmed ) [self undeployRightItems];
+    
+    _leftButtonItems = nil;
+    _rightButtonItems = nil;
+    _releaseItemOffsets( &_leftOffsets );
+    _releaseItemOffsets( &_rightOffsets );
+}
+
+
+// Replaces the items of both sides, nil items leave the corresponding side untouched. Deployed views are kept for items
+// already there and reconfigured for items replacing one of the same kind at the same index. Views for inserted items are
+// laid out for the passed in location right away, views for removed items are left in place. Both are returned to the caller,
+// which is in charge of animating them and of returning removed views to the pool
+- (void)reloadLeftItems:(NSArray*)leftItems rightItems:(NSArray*)rightItems location:(CGFloat)xLocation
+    insertedViews:(NSMutableArray*)insertedViews removedViews:(NSMutableArray*)removedViews
+{
+    if ( leftItems ) [self _reloadItems:leftItems forNewPosition:SWCellRevealPositionLeft insertedViews:insertedViews removedViews:removedViews];
+    if ( rightItems ) [self _reloadItems:rightItems forNewPosition:SWCellRevealPositionRight insertedViews:insertedViews removedViews:removedViews];
+    
+    if ( insertedViews.count == 0 )
+        return;
+    
+    NSSet *filter = [NSSet setWithArray:insertedViews];
+    
+    [UIView performWithoutAnimation:^
+    {
+        if ( _layerBacksItems )
+        {
+            [CATransaction begin];
+            [CATransaction setDisableActions:YES];
+        }
+        
+        if ( xLocation <= 0 ) [self _layoutViewsForNewPosition:SWCellRevealPositionRight location:xLocation filter:filter];
+        if ( xLocation >= 0 ) [self _layoutViewsForNewPosition:SWCellRevealPositionLeft location:xLocation filter:filter];
+        
+        if ( _layerBacksItems )
+        {
+            [CATransaction commit];
+        }
+    }];
+    
+    // views inserted during a gesture are rasterized as they would on deployment
+    if ( _rasterizesItems )
+        for ( SWUtilityView *utilityView in insertedViews ) [utilityView setRasterized:YES];
+}
+
+
+- (void)_reloadItems:(NSArray*)items forNewPosition:(SWCellRevealPosition)newPosition
+    insertedViews:(NSMutableArray*)insertedViews removedViews:(NSMutableArray*)removedViews
+{
+    NSArray *oldItems = newPosition<SWCellRevealPositionCenter ? _leftButtonItems : _rightButtonItems;
+    NSMutableArray * __strong* views = newPosition<SWCellRevealPositionCenter ? &_leftViews : &_rightViews;
+    BOOL reversedCascade = newPosition<SWCellRevealPositionCenter ? _c.leftCascadeReversed : _c.rightCascadeReversed;
+    UIViewAutoresizing mask = UIViewAutoresizingFlexibleHeight |
+        (!!reversedCascade == newPosition<SWCellRevealPositionCenter ? UIViewAutoresizingFlexibleLeftMargin: UIViewAutoresizingFlexibleRightMargin);
+    BOOL *prewarmed = newPosition<SWCellRevealPositionCenter ? &_leftViewsPrewarmed : &_rightViewsPrewarmed;
+    
+    // a side with no views on screen just takes the new items, views will be deployed for them when needed
+    if ( *views == nil || *prewarmed )
+    {
+        if ( *prewarmed ) [self _undeployItemsForNewPosition:newPosition];
+        [self _setItems:items forNewPosition:newPosition];
+        return;
+    }
+    
+    NSArray *oldViews = *views;
+    NSInteger oldCount = MIN(oldItems.count, oldViews.count);
+    NSInteger count = items.count;
+    
+    // views taken by a new item, claimed[i] is set when the old view at index i is kept
+    BOOL claimed[oldCount+1];
+    memset(claimed, 0, sizeof(claimed));
+    
+    // views are retained by the old views array or by the dequeued views array, callers may pass nil arrays
+    __unsafe_unretained SWUtilityView *newViews[count+1];
+    NSMutableArray *dequeuedViews = [NSMutableArray array];
+    
+    // first keep the views of items that are still there
+    for ( NSInteger i=0 ; i<count ; i++ )
+    {
+        newViews[i] = nil;
+        NSUInteger index = [oldItems indexOfObjectIdenticalTo:[items objectAtIndex:i]];
+        if ( index != NSNotFound && index < oldCount && !claimed[index] )
+        {
+            newViews[i] = [oldViews objectAtIndex:index];
+            claimed[index] = YES;
+        }
+    }
+    
+    // then reuse views of replaced items at the same index, and get new views for the remaining ones
+    for ( NSInteger i=0 ; i<count ; i++ )
+    {
+        if ( newViews[i] )
+            continue;
+        
+        SWCellButtonItem *item = [items objectAtIndex:i];
+        if ( i < oldCount && !claimed[i] && [[oldViews objectAtIndex:i] kind] == _utilityViewKindForItem(item) )
+        {
+            newViews[i] = [oldViews objectAtIndex:i];
+            claimed[i] = YES;
+        }
+        else
+        {
+            // the dequeued view is only ours, we must retain it before storing it in the unretained array
+            SWUtilityView *utilityView = [self _dequeueUtilityViewForItem:item mask:mask];
+            [dequeuedViews addObject:utilityView];
+            [insertedViews addObject:utilityView];
+            newViews[i] = utilityView;
+        }
+    }
+    
+    // views not taken by any item are removed
+    for ( NSInteger i=0 ; i<oldCount ; i++ )
+    {
+        if ( !claimed[i] )
+            [removedViews addObject:[oldViews objectAtIndex:i]];
+    }
+    
+    // update kept views, only changed properties are set and snapshots of changed views are discarded
+    NSMutableArray *reloadedViews = [NSMutableArray arrayWithCapacity:count];
+    for ( NSInteger i=0 ; i<count ; i++ )
+    {
+        SWUtilityView *utilityView = newViews[i];
+        SWCellButtonItem *item = [items objectAtIndex:i];
+        BOOL changed = [self _configureUtilityView:utilityView forItem:item];
+        
+        CGFloat width = _resolvedItemWidth(item);
+        if ( utilityView.button.bounds.size.width != width )
+        {
+            [utilityView setButtonWidth:width];
+            changed = YES;
+        }
+        
+        if ( changed && utilityView.rasterized )
+        {
+            [utilityView discardSnapshot];
+            [utilityView setRasterized:YES];
+        }
+        
+        [reloadedViews addObject:utilityView];
+        
+        // stack views in item order, as they are on deployment
+        if ( reversedCascade ) [self insertSubview:utilityView atIndex:0];
+        else [self addSubview:utilityView];
+    }
+    
+    *views = count > 0 ? reloadedViews : nil;
+    [self _setItems:items forNewPosition:newPosition];
+}
+
+
+- (void)_setItems:(NSArray*)items forNewPosition:(SWCellRevealPosition)newPosition
+{
+    if ( newPosition<SWCellRevealPositionCenter )
+    {
+        _leftButtonItems = items;
+        _releaseItemOffsets( &_leftOffsets );
+        _leftOffsets = _itemOffsetsForItems(_leftButtonItems, 1);
+    }
+    else
+    {
+        _rightButtonItems = items;
+        _releaseItemOffsets( &_rightOffsets );
+        _rightOffsets = _itemOffsetsForItems(_rightButtonItems, -1);
+    }
+}
+
+
+- (void)_prepareLeftButtonItems
+{
+    if ( _leftButtonItems == nil )
+    {
+        _leftButtonItems = [_c _getLeftButtonItems];
+        _releaseItemOffsets( &_leftOffsets );
+        _leftOffsets = _itemOffsetsForItems(_leftButtonItems, 1);
+    }
+}
+
+
+- (void)_prepareRightButtonItems
+{
+    if ( _rightButtonItems == nil )
+    {
+        _rightButtonItems = [_c _getRightButtonItems];
+        _releaseItemOffsets( &_rightOffsets );
+        _rightOffsets = _itemOffsetsForItems(_rightButtonItems, -1);
+    }
+}
+
+
+- (void)_deployItemsForNewPosition:(SWCellRevealPosition)newPosition
+{
+    NSArray *items = newPosition<SWCellRevealPositionCenter ? _leftButtonItems : _rightButtonItems;
+    NSMutableArray * __strong* views =  newPosition<SWCellRevealPositionCenter ? &_leftViews : &_rightViews;
+    BOOL reversedCascade = newPosition<SWCellRevealPositionCenter ? _c.leftCascadeReversed : _c.rightCascadeReversed;
+    UIViewAutoresizing mask = UIViewAutoresizingFlexibleHeight |
+        (!!reversedCascade == newPosition<SWCellRevealPositionCenter ? UIViewAutoresizingFlexibleLeftMargin: UIViewAutoresizingFlexibleRightMargin);
+    BOOL *prewarmed = newPosition<SWCellRevealPositionCenter ? &_leftViewsPrewarmed : &_rightViewsPrewarmed;
+    
+    // views may be already there from a prewarm, we only need to show them
+    if ( *prewarmed )
+    {
+        for ( SWUtilityView *utilityView in *views ) [utilityView setHidden:NO];
+        for ( SWUtilityView *utilityView in *views ) [utilityView setRasterized:_rasterizesItems];
+        *prewarmed = NO;
+        return;
+    }
+
+    if ( items.count == 0 )
+        return;
+    
+    *views = [NSMutableArray array];
+    
+    for ( SWCellButtonItem *item in items )
+    {
+        SWUtilityView *utilityView = [self _dequeueUtilityViewForItem:item mask:mask];
+        [*views addObject:utilityView];
+        
+        if ( reversedCascade ) [self insertSubview:utilityView atIndex:0];
+        else [self addSubview:utilityView];
+    }
+    
+    CGFloat xLocation = [self frontLocationForPosition:SWCellRevealPositionCenter];
+    [self layoutForLocation:xLocation];
+    
+    // views deployed during a gesture are rasterized right away, now that they got their height
+    if ( _rasterizesItems )
+        for ( SWUtilityView *utilityView in *views ) [utilityView setRasterized:YES];
+}
+
+
+- (SWUtilityView*)_dequeueUtilityViewForItem:(SWCellButtonItem*)item mask:(UIViewAutoresizing)mask
+{
+    // get the button item
+    NSAssert( [item isKindOfClass:[SWCellButtonItem class]], @"Cell button items must be of class SWCellButtonItem" );
+
+    // get a utility view for the item, the pool gives us one already configured for this kind of item
+    SWUtilityView *utilityView = [_c.utilityViewPool _dequeueUtilityViewOfKind:_utilityViewKindForItem(item)];
+    [utilityView setFrame:CGRectMake(0, 0, _resolvedItemWidth(item), 20)];
+    
+    // set up the button
+    SWUtilityButton *button = utilityView.button;
+    button.autoresizingMask = mask;
+    button.frame = utilityView.bounds;
+    [utilityView setLayerBackedLayout:_layerBacksItems];
+    
+    [self _configureUtilityView:utilityView forItem:item];
+    return utilityView;
+}
+
+
+static inline BOOL _objectsEqual(id object, id other)
+{
+    return object == other || [object isEqual:other];
+}
+
+
+// Sets the item properties on a utility view. Only properties that differ from the current ones are set, so we can
+// call this on deployed views with no button layout for unchanged items. Returns whether anything changed
+- (BOOL)_configureUtilityView:(SWUtilityView*)utilityView forItem:(SWCellButtonItem*)item
+{
+    // get button item properties
+    UIColor *color = item.backgroundColor;
+    UIColor *tintColor = item.tintColor;
+    UIImage *image = item.image;
+    NSString *title = item.title;
+    
+    SWUtilityButton *button = utilityView.button;
+    BOOL changed = NO;
+    
+    // icons just get their image tinted as a button would do it, and the plain background color
+    if ( utilityView.kind == SWUtilityViewKindIcon )
+    {
+        UIImage *iconImage = _cachedTintedImage(image, tintColor ? tintColor : _c.tintColor);
+        
+        if ( !_objectsEqual(utilityView.customBackgroundColor, color) )
+        {
+            [utilityView setCustomBackgroundColor:color];
+            changed = YES;
+        }
+        
+        if ( utilityView.iconImage != iconImage )
+        {
+            [utilityView setIconImage:iconImage];
+            changed = YES;
+        }
+        
+        return changed;
+    }
+    
+#if SupportsVisualEffects
+    // set the visual effect
+    UIVisualEffectView *effectView = (UIVisualEffectView*)utilityView.effectView;
+    if ( effectView && !_objectsEqual(effectView.effect, item.visualEffect) )
+    {
+        [effectView setEffect:item.visualEffect];
+        changed = YES;
+    }
+#endif
+    
+    // set up the button
+    button.item = item;
+    button.contentView = self;
+    button.cell = _c;
+    item.button = button;
+    
+    // Depending on which item properties the developer has set, we chose configure the button to make the best of it
+    
+    UIColor *backgroundColor = (image && color) ? color : nil;
+    
+    if ( image==nil && color )
+    {
+        image = _cachedImageWithColor(color);
+    }
+    
+    if ( !_objectsEqual(utilityView.customBackgroundColor, backgroundColor) )
+    {
+        [utilityView setCustomBackgroundColor:backgroundColor];
+        changed = YES;
+    }
+    
+    // with no item tint color the button just inherits ours, so that is what it must match
+    if ( !_objectsEqual(button.tintColor, tintColor ? tintColor : utilityView.tintColor) )
+    {
+        [button setTintColor:tintColor];
+        changed = YES;
+    }
+    
+    if ( !_objectsEqual([button titleForState:UIControlStateNormal], title) )
+    {
+        [button setTitle:title forState:UIControlStateNormal];
+        changed = YES;
+    }
+    
+    if ( [button imageForState:UIControlStateNormal] != image )
+    {
+        [button setImage:image forState:UIControlStateNormal];
+        changed = YES;
+    }
+    
+    return changed;
+}
+
+
+// Reconfigures the deployed view of an item whose properties changed, if any
+- (void)updateViewForItem:(SWCellButtonItem*)item
+{
+    NSInteger index = item.index;
+    SWUtilityView *utilityView = nil;
+    
+    if ( index < _leftViews.count && [_leftButtonItems objectAtIndex:index] == item )
+        utilityView = [_leftViews objectAtIndex:index];
+    
+    else if ( index < _rightViews.count && [_rightButtonItems objectAtIndex:index] == item )
+        utilityView = [_rightViews objectAtIndex:index];
+    
+    if ( utilityView )
+        [self _configureUtilityView:utilityView forItem:item];
+}
+
+
+// Returns the index of the item at a distance from the edge where items start, or NSNotFound
+static NSInteger _itemIndexForDistance(SWItemOffsets itemOffsets, CGFloat distance)
+{
+    if ( distance < 0 )
+        return NSNotFound;
+    
+    for ( NSInteger i=0 ; i<itemOffsets.count ; i++ )
+    {
+        if ( distance < itemOffsets.offsets[i+1] )
+            return i;
+    }
+    
+    return NSNotFound;
+}
+
+
+// Returns the icon item at a point, items are hit tested on their fully revealed frames using the cached item offsets
+- (SWCellButtonItem*)_iconItemAtPoint:(CGPoint)point
+{
+    CGRect bounds = self.bounds;
+    NSArray *views = nil;
+    NSArray *items = nil;
+    NSInteger index = NSNotFound;
+    
+    if ( _rightViews && !_rightViewsPrewarmed )
+    {
+        index = _itemIndexForDistance(_rightOffsets, bounds.size.width - point.x);
+        views = _rightViews;
+        items = _rightButtonItems;
+    }
+    
+    if ( index == NSNotFound && _leftViews && !_leftViewsPrewarmed )
+    {
+        index = _itemIndexForDistance(_leftOffsets, point.x - bounds.origin.x);
+        views = _leftViews;
+        items = _leftButtonItems;
+    }
+    
+    if ( index == NSNotFound || index >= views.count || [[views objectAtIndex:index] kind] != SWUtilityViewKindIcon )
+        return nil;
+    
+    return [items objectAtIndex:index];
+}
+
+
+- (BOOL)gestureRecognizer:(UIGestureRecognizer *)gestureRecognizer shouldReceiveTouch:(UITouch *)touch
+{
+    // we do not want to get in the way of buttons, or of anything else
+    return [self _iconItemAtPoint:[touch locationInView:self]] != nil;
+}
+
+
+- (void)_handleIconTap:(UITapGestureRecognizer *)recognizer
+{
+    SWCellButtonItem *item = [self _iconItemAtPoint:[recognizer locationInView:self]];
+    
+    // items may be shared among cells, so we bind the item to the cell where it was tapped before calling its handler
+    item.view = self;
+    item.cell = _c;
+    item.button = nil;
+    [item _performHandler];
+}
+
+
+- (void)_undeployItemsForNewPosition:(SWCellRevealPosition)newPosition
+{
+    NSMutableArray * __strong* views = newPosition<SWCellRevealPositionCenter ? &_leftViews : &_rightViews;
+    BOOL *prewarmed = newPosition<SWCellRevealPositionCenter ? &_leftViewsPrewarmed : &_rightViewsPrewarmed;
+    SWUtilityViewPool *pool = _c.utilityViewPool;
+    
+    *prewarmed = NO;
+    
+    // return the views to the pool, this will also remove them from our hierarchy
+    for ( SWUtilityView *utilityView in *views )
     {
-        width += item.width;
+        [pool _enqueueUtilityView:utilityView];
     }
-    return width;
+    
+    *views = nil;
 }
 
 
-- (CGFloat)rightRevealWidth
+- (void)setLayoutStrategy:(id<SWRevealLayoutStrategy>)layoutStrategy
 {
-    CGFloat width = 0;
-    for ( SWCellButtonItem *item in _rightButtonItems )
-    {
-        width += item.width;
-    }
-    return width;
+    _layoutStrategy = layoutStrategy;
+    _layoutStyle = SWRevealLayoutStyleCascade;
+    _layoutFunction = NULL;
+    
+    // built in layouts are performed inline, others through a direct call to their implementation
+    if ( [layoutStrategy isMemberOfClass:[SWRevealLayout class]] )
+        _layoutStyle = [(SWRevealLayout*)layoutStrategy style];
+    
+    else if ( layoutStrategy )
+        _layoutFunction = (SWRevealLayoutFunction)[(id)layoutStrategy methodForSelector:
+            @selector(revealTableViewCell:getFrames:forItemOffsets:count:leftSide:progress:bounds:)];
 }
 
 
-- (CGRect)referenceFrameForCellButtonItem:(SWCellButtonItem*)targetItem
+// Lays out the views of one side for a front location. If a filter is passed, only views contained in it are laid out
+- (void)_layoutViewsForNewPosition:(SWCellRevealPosition)newPosition location:(CGFloat)xLocation filter:(NSSet*)filter
 {
-    SWCellButtonItem *item = nil;
-    CGRect bounds = self.bounds;
+    NSArray *views = newPosition<SWCellRevealPositionCenter? _leftViews : _rightViews;
+    SWItemOffsets itemOffsets = newPosition<SWCellRevealPositionCenter ? _leftOffsets : _rightOffsets;
+    CGFloat maxLocation = newPosition<SWCellRevealPositionCenter ? _itemOffsetsTotalWidth(_leftOffsets) : -_itemOffsetsTotalWidth(_rightOffsets);
+    
+    if ( maxLocation == 0 )
+        return;
     
-    CGFloat location = 0;
+    // the reveal progress, coefficients were computed when items were prepared so this is all we need
+    CGFloat progress = xLocation/maxLocation;
     
-    if ( item != targetItem)
+    NSInteger count = MIN(views.count, itemOffsets.count);
+    CGRect bounds = self.bounds;
+    CGFloat symmetry = maxLocation<0 ? -1 : 1;
+    CGFloat xReference = maxLocation<0 ? bounds.size.width : 0;
+    CGFloat revealWidth = maxLocation*symmetry;
+    const SWItemLayout *layout = itemOffsets.layout;
+    const CGRect *frames = itemOffsets.frames;
+    
+    if ( _layoutFunction )
     {
-        location = bounds.size.width;
-        for ( item in _rightButtonItems )
-        {
-            location = location - item.width;
-            if ( item == targetItem ) break;
-        }
+        SEL selector = @selector(revealTableViewCell:getFrames:forItemOffsets:count:leftSide:progress:bounds:);
+        _layoutFunction(_layoutStrategy, selector, _c, itemOffsets.frames, itemOffsets.offsets, count, symmetry>0, progress,
+            CGRectMake(0, 0, bounds.size.width, bounds.size.height));
     }
     
-    if ( item != targetItem)
+    NSInteger i = 0;
+    for ( SWUtilityView *utilityView in views )
     {
-        location = bounds.origin.x;
-        for ( item in _leftButtonItems )
+        if ( i == count )
+            break;
+        
+        if ( filter && ![filter containsObject:utilityView] )
         {
-            if ( item == targetItem ) break;
-            location = location + item.width;
+            i++;
+            continue;
         }
+        
+        CGRect frame = _layoutFunction ? frames[i] :
+            _builtInItemFrame(_layoutStyle, layout[i], xReference, symmetry, revealWidth, progress, bounds.size.height);
+        
+        [utilityView setLayoutFrame:frame];
+        i++;
     }
+}
 
-    CGRect referenceFrame = bounds;
-    referenceFrame.origin.x = location;
-    referenceFrame.size.width = item.width;
 
-    return referenceFrame;
-}
+@end
 
 
-- (void)deployRightItems
+#pragma mark - UIActionSheetExtension
+
+@implementation UIActionSheet(SWCellButtonItem)
+
+- (void)showFromCellButtonItem:(SWCellButtonItem *)item animated:(BOOL)animated
 {
-    [self _deployItemsForNewPosition:SWCellRevealPositionRight];
+    SWUtilityContentView *utilityView = item.view;
+    CGRect frame = [utilityView referenceFrameForCellButtonItem:item];
+    
+    [self showFromRect:frame inView:utilityView animated:animated];
 }
 
+@end
+
 
-- (void)undeployRightItems
+#pragma mark - SWCellButtonItemMenu
+
+@interface SWCellButtonItemMenuAction : NSObject
+@property (nonatomic) NSString *title;
+@property (nonatomic) UIAlertActionStyle style;
+@property (nonatomic, copy) void (^handler)(SWCellButtonItem *, SWRevealTableViewCell*);
+@end
+
+
+@implementation SWCellButtonItemMenuAction
+@end
+
+
+@interface SWCellButtonItemMenu()<UIActionSheetDelegate>
+@end
+
+
+@implementation SWCellButtonItemMenu
 {
-    [self _undeployItemsForNewPosition:SWCellRevealPositionRight];
+    NSMutableArray *_actions;
+    __weak UIAlertController *_alertController;  // the presented controller, if any
+    UIActionSheet *_actionSheet;                 // the presented action sheet on iOS7, if any
+    NSArray *_actionSheetActions;                // actions by action sheet button index
+    __weak SWCellButtonItem *_presentedItem;
+    __weak SWRevealTableViewCell *_presentedCell;
 }
 
 
-- (void)deployLeftItems
++ (instancetype)menuWithTitle:(NSString *)title message:(NSString *)message
 {
-    [self _deployItemsForNewPosition:SWCellRevealPositionLeft];
+    SWCellButtonItemMenu *menu = [[SWCellButtonItemMenu alloc] init];
+    menu->_title = [title copy];
+    menu->_message = [message copy];
+    menu->_actions = [NSMutableArray array];
+    return menu;
 }
 
 
-- (void)undeployLeftItems
+- (void)addActionWithTitle:(NSString *)title style:(UIAlertActionStyle)style handler:(void (^)(SWCellButtonItem *, SWRevealTableViewCell *))handler
 {
-    [self _undeployItemsForNewPosition:SWCellRevealPositionLeft];
+    SWCellButtonItemMenuAction *action = [[SWCellButtonItemMenuAction alloc] init];
+    action.title = title;
+    action.style = style;
+    action.handler = handler;
+    [_actions addObject:action];
 }
 
 
-- (CGFloat)frontLocationForPosition:(SWCellRevealPosition)revealPosition
+- (void)presentFromCellButtonItem:(SWCellButtonItem *)item inViewController:(UIViewController *)viewController animated:(BOOL)animated
 {
-    int symmetry = revealPosition<SWCellRevealPositionCenter? -1 : 1;
+    SWUtilityContentView *contentView = item.view;
+    if ( contentView == nil || _alertController || _actionSheet )
+        return;
     
-    CGFloat location = 0.0f;
-    CGFloat itemsWidth = revealPosition<SWCellRevealPositionCenter? [self rightRevealWidth] : [self leftRevealWidth];
+    CGRect frame = [contentView referenceFrameForCellButtonItem:item];
     
-    [_c _getAdjustedRevealPosition:&revealPosition forSymmetry:symmetry];
+    _presentedItem = item;
+    _presentedCell = item.cell;
     
-    if ( revealPosition == SWCellRevealPositionRight )
-        location = itemsWidth;
+    if ( [UIAlertController class] )
+    {
+        UIAlertController *alertController = [self _buildAlertController];
+        _alertController = alertController;
+        
+        // this is only used where action sheets are shown as popovers
+        UIPopoverPresentationController *popover = alertController.popoverPresentationController;
+        popover.sourceView = contentView;
+        popover.sourceRect = frame;
+        
+        [viewController presentViewController:alertController animated:animated completion:nil];
+    }
+    else
+    {
+        _actionSheet = [self _buildActionSheet];
+        [_actionSheet showFromRect:frame inView:contentView animated:animated];
+    }
+}
+
+
+- (void)_performAction:(SWCellButtonItemMenuAction *)action
+{
+    SWCellButtonItem *item = _presentedItem;
+    SWRevealTableViewCell *cell = _presentedCell;
     
-    else if ( revealPosition > SWCellRevealPositionRight )
-        location = itemsWidth;
+    _presentedItem = nil;
+    _presentedCell = nil;
+    
+    if ( action.handler )
+        action.handler( item, cell );
+}
 
-    return location*symmetry;
+
+// Controllers are built for each presentation, UIKit does not support presenting an alert controller more than once
+- (UIAlertController *)_buildAlertController
+{
+    UIAlertController *alertController = [UIAlertController alertControllerWithTitle:_title message:_message
+        preferredStyle:UIAlertControllerStyleActionSheet];
+    
+    // actions do not retain us, the menu does not even keep the controller once dismissed
+    __weak SWCellButtonItemMenu *weakSelf = self;
+    for ( SWCellButtonItemMenuAction *action in _actions )
+    {
+        [alertController addAction:[UIAlertAction actionWithTitle:action.title style:action.style handler:^(UIAlertAction *alertAction)
+        {
+            [weakSelf _performAction:action];
+        }]];
+    }
+    
+    return alertController;
 }
 
 
-- (void)layoutForLocation:(CGFloat)xLocation
+- (UIActionSheet *)_buildActionSheet
 {
-    if ( xLocation <= 0 )
+    NSString *title = _message.length > 0 ? [NSString stringWithFormat:@"%@\n%@", _title ? _title : @"", _message] : _title;
+    UIActionSheet *actionSheet = [[UIActionSheet alloc] initWithTitle:title delegate:self cancelButtonTitle:nil
+        destructiveButtonTitle:nil otherButtonTitles:nil];
+    
+    // the cancel button goes last, as UIActionSheet wants it
+    NSMutableArray *sheetActions = [NSMutableArray array];
+    SWCellButtonItemMenuAction *cancelAction = nil;
+    
+    for ( SWCellButtonItemMenuAction *action in _actions )
     {
-        [self _layoutViewsForNewPosition:SWCellRevealPositionRight location:xLocation];
+        if ( action.style == UIAlertActionStyleCancel )
+        {
+            cancelAction = action;
+            continue;
+        }
+        
+        NSInteger index = [actionSheet addButtonWithTitle:action.title];
+        if ( action.style == UIAlertActionStyleDestructive && actionSheet.destructiveButtonIndex < 0 )
+            [actionSheet setDestructiveButtonIndex:index];
+        
+        [sheetActions addObject:action];
     }
     
-    if ( xLocation >= 0 )
+    if ( cancelAction )
     {
-        [self _layoutViewsForNewPosition:SWCellRevealPositionLeft location:xLocation];
+        [actionSheet setCancelButtonIndex:[actionSheet addButtonWithTitle:cancelAction.title]];
+        [sheetActions addObject:cancelAction];
     }
+    
+    _actionSheetActions = sheetActions;
+    return actionSheet;
 }
 
 
-- (void)resetButtonItems
+- (void)actionSheet:(UIActionSheet *)actionSheet didDismissWithButtonIndex:(NSInteger)buttonIndex
 {
-    _leftButtonItems = nil;
-    _rightButtonItems = nil;
+    NSArray *sheetActions = _actionSheetActions;
+    _actionSheet = nil;
+    _actionSheetActions = nil;
+    
+    // dismissing with no action gives the cancel button index, or -1 if there is no cancel button
+    if ( buttonIndex >= 0 && buttonIndex < (NSInteger)sheetActions.count )
+        [self _performAction:[sheetActions objectAtIndex:buttonIndex]];
+    else
+        [self _performAction:nil];
 }
 
+@end
+
 
-- (void)_prepareLeftButtonItems
+#pragma mark - UITableViewExtension
+
+@implementation UITableView(SWRevealTableViewCell)
+
+- (void)prepareRevealButtonItemsForRowsAtIndexPaths:(NSArray *)indexPaths
 {
-    if ( _leftButtonItems == nil )
-        _leftButtonItems = [_c _getLeftButtonItems];
+    for ( NSIndexPath *indexPath in indexPaths )
+    {
+        SWRevealTableViewCell *cell = (id)[self cellForRowAtIndexPath:indexPath];
+        if ( [cell isKindOfClass:[SWRevealTableViewCell class]] )
+            [cell prepareButtonItemsIfNeeded];
+    }
 }
 
+@end
 
-- (void)_prepareRightButtonItems
+
+#pragma mark - SWRevealGestureMetrics
+
+@interface SWRevealGestureMetrics()
+@property (nonatomic) CFTimeInterval beganTime;
+@property (nonatomic) NSTimeInterval duration;
+@property (nonatomic) NSInteger frameCount;
+@property (nonatomic) NSTimeInterval worstFrameDuration;
+@property (nonatomic) NSTimeInterval deployDuration;
+@property (nonatomic) NSInteger builtItemCount;
+@end
+
+
+@implementation SWRevealGestureMetrics
+
+- (NSString*)description
 {
-    if ( _rightButtonItems == nil )
-        _rightButtonItems = [_c _getRightButtonItems];
+    return [NSString stringWithFormat:@"<%@: %p; duration = %.4f; frames = %ld; worstFrame = %.4f; deploy = %.4f; builtItems = %ld>",
+        NSStringFromClass([self class]), self, _duration, (long)_frameCount, _worstFrameDuration, _deployDuration, (long)_builtItemCount];
 }
 
+@end
 
-- (void)_deployItemsForNewPosition:(SWCellRevealPosition)newPosition
+
+#pragma mark - SWRevealResourceUsage
+
+@interface SWRevealResourceUsage()
+@property (nonatomic) NSUInteger itemCount;
+@property (nonatomic) NSUInteger utilityViewCount;
+@property (nonatomic) NSUInteger pooledViewCount;
+@property (nonatomic) NSUInteger cachedImageCount;
+@property (nonatomic) NSUInteger cachedItemArrayCount;
+@end
+
+
+@implementation SWRevealResourceUsage
+
+- (NSString*)description
 {
-    NSArray *items = newPosition<SWCellRevealPositionCenter ? _leftButtonItems : _rightButtonItems;
-    NSMutableArray * __strong* views =  newPosition<SWCellRevealPositionCenter ? &_leftViews : &_rightViews;
-    BOOL reversedCascade = newPosition<SWCellRevealPositionCenter ? _c.leftCascadeReversed : _c.rightCascadeReversed;
-    UIViewAutoresizing mask = UIViewAutoresizingFlexibleHeight |
-        (!!reversedCascade == newPosition<SWCellRevealPositionCenter ? UIViewAutoresizingFlexibleLeftMargin: UIViewAutoresizingFlexibleRightMargin);
+    return [NSString stringWithFormat:@"<%@: %p; items = %lu; utilityViews = %lu; pooledViews = %lu; cachedImages = %lu; cachedItemArrays = %lu>",
+        NSStringFromClass([self class]), self, (unsigned long)_itemCount, (unsigned long)_utilityViewCount, (unsigned long)_pooledViewCount,
+        (unsigned long)_cachedImageCount, (unsigned long)_cachedItemArrayCount];
+}
 
-    if ( items.count == 0 )
-        return;
-    
-    *views = [NSMutableArray array];
-    
-    for ( SWCellButtonItem *item in items )
+@end
+
+
+#pragma mark - SWRevealTableViewCellCoordinator
+
+@interface SWRevealTableViewCellCoordinator()
+- (void)_revealTableViewCell:(SWRevealTableViewCell *)cell willMoveToPosition:(SWCellRevealPosition)position;
+- (void)_revealTableViewCellPanGestureBegan:(SWRevealTableViewCell *)cell;
+- (void)_revealTableViewCellPrepareForReuse:(SWRevealTableViewCell *)cell;
+- (BOOL)_suspendsRevealGestures;
+@end
+
+
+@implementation SWRevealTableViewCellCoordinator
+{
+    id<NSCopying> _revealedRowIdentifier;
+    SWCellRevealPosition _revealedPosition;
+}
+
+
+- (instancetype)initWithTableView:(UITableView *)tableView
+{
+    self = [super init];
+    if ( self )
     {
-        // get the button item
-        NSAssert( [item isKindOfClass:[SWCellButtonItem class]], @"Cell button items must be of class SWCellButtonItem" );
-        
-        // get button item properties
-        UIColor *color = item.backgroundColor;
-        UIColor *tintColor = item.tintColor;
-        UIImage *image = item.image;
-        NSString *title = item.title;
-    
-        // create a utility view for the item
-        SWUtilityView *utilityView = [[SWUtilityView alloc] initWithFrame:CGRectMake(0, 0, item.width, 20)];
-        [utilityView setClipsToBounds:YES];
-        
-#if SupportsVisualEffects
-        // add a visual effect
-        UIVisualEffect *effect = item.visualEffect;
-        if ( effect )
-        {
-            UIVisualEffectView *effectView = [[UIVisualEffectView alloc] initWithEffect:effect];
-            effectView.autoresizingMask = UIViewAutoresizingFlexibleHeight|UIViewAutoresizingFlexibleWidth;
-            effectView.frame = utilityView.bounds;
-            [utilityView addSubview:effectView];
-        }
-#endif
-        
-        // add a button
-        SWUtilityButton *button = [SWUtilityButton buttonWithType:UIButtonTypeSystem];
-        [button addTarget:self action:@selector(_buttonTouchUpAction:) forControlEvents:UIControlEventTouchUpInside];
-        button.autoresizingMask = mask;
-        
-        button.frame = utilityView.bounds;
-        button.titleLabel.numberOfLines = 0;
-        button.titleLabel.textAlignment = NSTextAlignmentCenter;
-        button.item = item;
-        
-        // Depending on which item properties the developer has set, we chose configure the button to make the best of it
-        
-        if ( image )
-        {
-            // we do not want to scale user provided images
-            [button.imageView setContentMode:UIViewContentModeCenter];
-        }
-        
-        if ( image && title.length>0 )
-        {
-            [button.titleLabel setFont:[UIFont preferredFontForTextStyle:UIFontTextStyleFootnote]];
-            [button setWantsCombinedLayout:YES];
-        }
-        
-        if ( image && color )
-        {
-            [utilityView setCustomBackgroundColor:color];
-        }
-        
-        if ( image==nil && color )
-        {
-            image = _imageWithColor_size(color, CGSizeMake(1,1));
-            image = [image imageWithRenderingMode:UIImageRenderingModeAlwaysOriginal];
-            [button.imageView setContentMode:UIViewContentModeScaleToFill];
-        }
-        
-        [button setTintColor:tintColor];
-        [button setTitle:title forState:UIControlStateNormal];
-        [button setImage:image forState:UIControlStateNormal];
-        
-        item.button = button;
-        
-        [utilityView addSubview:button];
-        [*views addObject:utilityView];
+        _tableView = tableView;
+        _closesOnScroll = YES;
+        _suspendsRevealWhileScrolling = YES;
+        _revealedPosition = SWCellRevealPositionCenter;
         
-        if ( reversedCascade ) [self insertSubview:utilityView atIndex:0];
-        else [self addSubview:utilityView];
+        // we get to know about scrolling by just tracking the table view pan gesture
+        [tableView.panGestureRecognizer addTarget:self action:@selector(_tableViewPanGestureRecognized:)];
     }
+    return self;
+}
+
+
+- (void)dealloc
+{
+    [_tableView.panGestureRecognizer removeTarget:self action:@selector(_tableViewPanGestureRecognized:)];
+}
+
+
+- (id<NSCopying>)_rowIdentifierForIndexPath:(NSIndexPath *)indexPath
+{
+    if ( indexPath == nil )
+        return nil;
     
-    CGFloat xLocation = [self frontLocationForPosition:SWCellRevealPositionCenter];
-    [self layoutForLocation:xLocation];
+    if ( _rowIdentifierProvider )
+        return _rowIdentifierProvider(indexPath);
+    
+    return indexPath;
 }
 
 
-- (void)_undeployItemsForNewPosition:(SWCellRevealPosition)newPosition
+- (void)configureCell:(SWRevealTableViewCell *)cell forRowAtIndexPath:(NSIndexPath *)indexPath
 {
-    NSMutableArray * __strong* views = newPosition<SWCellRevealPositionCenter ? &_leftViews : &_rightViews;
+    cell.coordinator = self;
     
-    for ( SWUtilityView *utilityView in *views )
+    if ( _revealedRowIdentifier == nil )
+        return;
+    
+    id<NSCopying> rowIdentifier = [self _rowIdentifierForIndexPath:indexPath];
+    if ( [(id)rowIdentifier isEqual:_revealedRowIdentifier] )
     {
-        [utilityView removeFromSuperview];
+        // the cell is not on screen yet, so this will just set the position to be silently applied when it gets there
+        _revealedCell = cell;
+        _revealedIndexPath = indexPath;
+        [cell restoreRevealPosition:_revealedPosition];
     }
-    
-    *views = nil;
 }
 
 
-- (void)_layoutViewsForNewPosition:(SWCellRevealPosition)newPosition location:(CGFloat)xLocation //symmetry:(NSInteger)symmetry
+- (void)closeRevealedCellAnimated:(BOOL)animated
 {
-    NSArray *views = newPosition<SWCellRevealPositionCenter? _leftViews : _rightViews;
-    NSArray *items = newPosition<SWCellRevealPositionCenter ? _leftButtonItems : _rightButtonItems;
-    CGFloat maxLocation = newPosition<SWCellRevealPositionCenter ? [self leftRevealWidth] : -[self rightRevealWidth] ;
-    CGFloat symmetry = newPosition<SWCellRevealPositionCenter ? 1 : -1;
+    SWRevealTableViewCell *cell = _revealedCell;
     
-    if ( abs(xLocation) > abs(maxLocation) ) xLocation = maxLocation;
+    // we forget the revealed row first, closing the cell will not report back if it is not on screen
+    _revealedCell = nil;
+    _revealedIndexPath = nil;
+    _revealedRowIdentifier = nil;
+    _revealedPosition = SWCellRevealPositionCenter;
     
-    NSInteger count = views.count;
-    CGSize size = self.bounds.size;
-    
-    CGFloat endLocation = 0;
-    for ( NSInteger i=0 ; i<count ; i++ )
-    {
-        SWCellButtonItem *item = [items objectAtIndex:i];
-        
-        CGFloat width = item.width;
-        endLocation += width*symmetry;
-        
-        CGFloat lWidth = width*xLocation/maxLocation;
-        CGFloat location =  xLocation*(endLocation/maxLocation);
-        
-        CGFloat xReference = symmetry<0 ? size.width+0 : 0-lWidth;
+    [cell setRevealPosition:SWCellRevealPositionCenter animated:animated];
+}
 
-// This works better on iOS8
-//        CGFloat x = 0.5*floor(2*(xReference+location));
-//        CGFloat w = 0.5*ceil(2*lWidth);
-        
-// This works better on iOS7
-        CGFloat x = floor(xReference+location);
-        CGFloat w = ceil(lWidth);
-        
-        CGRect frame = CGRectMake(x, 0, w, size.height);
-        
-        SWUtilityView *utilityView = [views objectAtIndex:i];
-        [utilityView setFrame:frame];
-    }
+
+- (void)_tableViewPanGestureRecognized:(UIPanGestureRecognizer *)recognizer
+{
+    if ( _closesOnScroll && recognizer.state == UIGestureRecognizerStateBegan && _revealedRowIdentifier )
+        [self closeRevealedCellAnimated:YES];
 }
 
 
-- (void)_buttonTouchUpAction:(SWUtilityButton*)button
+- (void)_revealTableViewCell:(SWRevealTableViewCell *)cell willMoveToPosition:(SWCellRevealPosition)position
 {
-    SWCellButtonItem *item = button.item;
-    void (^handler)(SWCellButtonItem*,SWRevealTableViewCell*) = item.handler;
+    if ( position == SWCellRevealPositionCenter )
+    {
+        if ( cell == _revealedCell )
+        {
+            _revealedCell = nil;
+            _revealedIndexPath = nil;
+            _revealedRowIdentifier = nil;
+            _revealedPosition = SWCellRevealPositionCenter;
+        }
+        return;
+    }
+    
+    // keep track of the new revealed cell before closing the previous one, so we ignore its notification
+    SWRevealTableViewCell *previousCell = _revealedCell;
+    
+    _revealedCell = cell;
+    _revealedIndexPath = [_tableView indexPathForCell:cell];
+    _revealedRowIdentifier = [(id)[self _rowIdentifierForIndexPath:_revealedIndexPath] copy];
+    _revealedPosition = position;
     
-    if ( handler )
-        handler( item, _c );
+    if ( previousCell != cell )
+        [previousCell setRevealPosition:SWCellRevealPositionCenter animated:YES];
 }
 
-@end
 
+- (void)_revealTableViewCellPanGestureBegan:(SWRevealTableViewCell *)cell
+{
+    if ( _revealedCell != cell && _revealedRowIdentifier )
+        [self closeRevealedCellAnimated:YES];
+}
 
-#pragma mark - UIActionSheetExtension
 
-@implementation UIActionSheet(SWCellButtonItem)
+- (void)_revealTableViewCellPrepareForReuse:(SWRevealTableViewCell *)cell
+{
+    // the revealed row stays revealed, we just detach its cell so the reuse reset is not taken as a close
+    if ( cell == _revealedCell )
+        _revealedCell = nil;
+}
 
-- (void)showFromCellButtonItem:(SWCellButtonItem *)item animated:(BOOL)animated
+
+- (BOOL)_suspendsRevealGestures
 {
-    SWUtilityContentView *utilityView = item.view;
-    CGRect frame = [utilityView referenceFrameForCellButtonItem:item];
+    if ( !_suspendsRevealWhileScrolling )
+        return NO;
     
-    [self showFromRect:frame inView:utilityView animated:animated];
+    UITableView *tableView = _tableView;
+    return tableView.decelerating || tableView.dragging;
 }
 
 @end
@@ -572,13 +2492,25 @@ static UIImage* _imageWithColor_size(UIColor* color, CGSize size)
 #pragma mark - SWDirectionPanGestureRecognizer
 
 @interface SWRevealTableViewCellPanGestureRecognizer : UIPanGestureRecognizer
+@property (nonatomic) CGFloat directionThreshold;
+@property (nonatomic) CGFloat directionMaximumAngle;
 @end
 
 
-@implementation SWRevealTableViewCellPanGestureRecognizer
+@implementation SWRevealTableViewCellPanGestureRecognizer
+{
+    BOOL _dragging;
+    CGPoint _beginPoint;
+    CGFloat _directionMaximumSlope;
+}
+
+
+- (void)setDirectionMaximumAngle:(CGFloat)directionMaximumAngle
 {
-    BOOL _dragging;
-    CGPoint _beginPoint;
+    _directionMaximumAngle = directionMaximumAngle;
+    
+    // keep the slope, so touch moves are tested with no trigonometry
+    _directionMaximumSlope = directionMaximumAngle >= 90 ? CGFLOAT_MAX : tan(directionMaximumAngle*M_PI/180);
 }
 
 
@@ -599,13 +2531,14 @@ static UIImage* _imageWithColor_size(UIColor* color, CGSize size)
     if ( _dragging || self.state == UIGestureRecognizerStateFailed)
         return;
     
-    const int kDirectionPanThreshold = 5;
-    
     UITouch *touch = [touches anyObject];
     CGPoint nowPoint = [touch locationInView:self.view];
     
-    if (abs(nowPoint.x - _beginPoint.x) > kDirectionPanThreshold) _dragging = YES;
-    else if (abs(nowPoint.y - _beginPoint.y) > kDirectionPanThreshold) self.state = UIGestureRecognizerStateFailed;
+    CGFloat dx = fabs(nowPoint.x - _beginPoint.x);
+    CGFloat dy = fabs(nowPoint.y - _beginPoint.y);
+    
+    if (dx > _directionThreshold && dy <= dx*_directionMaximumSlope) _dragging = YES;
+    else if (dx > _directionThreshold || dy > _directionThreshold) self.state = UIGestureRecognizerStateFailed;
 }
 
 @end
@@ -613,14 +2546,87 @@ static UIImage* _imageWithColor_size(UIColor* color, CGSize size)
 
 #pragma mark - SWrevealTableViewCell
 
+// Kinds of requests kept in the cell request queue
+typedef NS_ENUM(NSInteger, SWRevealRequestKind)
+{
+    SWRevealRequestKindPosition,    // programmatic position change
+    SWRevealRequestKindGesture,     // holds the queue while a pan gesture is in progress
+    SWRevealRequestKindReloadItems, // button items reload, see reloadButtonItemsAnimated:
+};
+
+
+typedef struct
+{
+    SWRevealRequestKind kind;
+    SWCellRevealPosition position;
+    BOOL animated;
+} SWRevealRequest;
+
+
+// A fixed capacity ring buffer of requests, the request at head is the one in process.
+// Pending requests are coalesced by kind, so there is at most one pending position request, one pending reload
+// and one pending gesture, and the queue never gets full
+#define SWRevealRequestQueueCapacity 4
+
+typedef struct
+{
+    SWRevealRequest requests[SWRevealRequestQueueCapacity];
+    NSInteger head;
+    NSInteger count;
+} SWRevealRequestQueue;
+
+
+// Returns the request at the given offset from the head
+static inline SWRevealRequest *_requestQueueAt(SWRevealRequestQueue *queue, NSInteger offset)
+{
+    return &queue->requests[(queue->head + offset) % SWRevealRequestQueueCapacity];
+}
+
+
+// Removes the request at the given offset from the head, following requests keep their order
+static void _requestQueueRemove(SWRevealRequestQueue *queue, NSInteger offset)
+{
+    for ( NSInteger i=offset ; i<queue->count-1 ; i++ )
+        *_requestQueueAt(queue, i) = *_requestQueueAt(queue, i+1);
+    
+    queue->count -= 1;
+}
+
+
+// Inserts a request at the given offset from the head, the queue must not be full
+static void _requestQueueInsert(SWRevealRequestQueue *queue, NSInteger offset, SWRevealRequest request)
+{
+    for ( NSInteger i=queue->count ; i>offset ; i-- )
+        *_requestQueueAt(queue, i) = *_requestQueueAt(queue, i-1);
+    
+    *_requestQueueAt(queue, offset) = request;
+    queue->count += 1;
+}
+
+
 @interface SWRevealTableViewCell ()<UIGestureRecognizerDelegate>
 {
-    UIPanGestureRecognizer *_panGestureRecognizer;
+    SWRevealTableViewCellPanGestureRecognizer *_panGestureRecognizer;
     SWUtilityContentView *_utilityContentView;
     SWCellRevealPosition _frontViewPosition;
     SWCellRevealPosition _leftViewPosition;
     SWCellRevealPosition _rightViewPosition;
-    SWCellRevealPosition _panInitialFrontPosition;
+    CGFloat _panInitialLocation;
+    
+    // optional delegate methods implemented by the current delegate, set in setDelegate:
+    struct
+    {
+        unsigned int panGestureBegan:1;
+        unsigned int panGestureBeganFromLocation:1;
+        unsigned int panGestureMovedToLocation:1;
+        unsigned int panGestureEndedToLocation:1;
+        unsigned int panGestureEnded:1;
+        unsigned int animateToPosition:1;
+        unsigned int willMoveToPosition:1;
+        unsigned int didMoveToPosition:1;
+        unsigned int panGestureShouldRecognizeSimultaneously:1;
+        unsigned int panGestureShouldBegin:1;
+    } _delegateFlags;
 }
 
 @end
@@ -628,9 +2634,21 @@ static UIImage* _imageWithColor_size(UIColor* color, CGSize size)
 
 @implementation SWRevealTableViewCell
 {
-    NSMutableArray *_animationQueue;
+    SWRevealRequestQueue _requestQueue;
+    void (^_revealAnimationCompletion)(BOOL);
+    NSUInteger _revealAnimationRevision;
     CGFloat _revealLocation;
     __weak UIView *_revealLayoutView;
+    NSMutableArray *_revealOffsetViews;
+    CADisplayLink *_panDisplayLink;
+    CGFloat _panTranslation;
+    BOOL _panUpdatePending;
+    BOOL _prewarmScheduled;
+    NSUInteger _idleResourceRevision;
+    BOOL _restoresRevealPosition;
+    BOOL _performsRevealAnimations;
+    CGFloat _overdrawDamperWidth;
+    SWRevealGestureMetrics *_gestureMetrics;
 }
 
 const NSInteger SWCellRevealPositionNone = 0xff;
@@ -675,7 +2693,10 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     _bounceBackOnLeftOverdraw = YES;
     _rightCascadeReversed = NO;
     _leftCascadeReversed = NO;
-    _animationQueue = [NSMutableArray array];
+    _utilityViewPool = [SWUtilityViewPool sharedPool];
+    _overdrawDamperWidth = 80;
+    _panDirectionThreshold = 5;
+    _panDirectionMaximumAngle = 90;
 }
 
 
@@ -683,6 +2704,8 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 {
     _panGestureRecognizer = [[SWRevealTableViewCellPanGestureRecognizer alloc] initWithTarget:self action:@selector(_handleRevealGesture:)];
     _panGestureRecognizer.delegate = self;
+    _panGestureRecognizer.directionThreshold = _panDirectionThreshold;
+    _panGestureRecognizer.directionMaximumAngle = _panDirectionMaximumAngle;
     
     UIView *contentView = self.contentView;
     [contentView addGestureRecognizer:_panGestureRecognizer];
@@ -695,12 +2718,25 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 {
     [super prepareForReuse];
     
+    [_coordinator _revealTableViewCellPrepareForReuse:self];
+    [self _cancelIdleResourceRelease];
+    
     // By default we disable rear buttons when the cell is reused.
     // Developers can reverse this by explicitly setting position in their cellForRowAtIndexPath or willDisplay methods
     [self resetCellAnimated:NO];
 }
 
 
+- (void)setHidden:(BOOL)hidden
+{
+    [super setHidden:hidden];
+    
+    // hidden cells are not on screen, as are cells waiting in a table view reuse queue, so they do not need prewarmed items
+    if ( hidden )
+        [self releaseIdleResources];
+}
+
+
 - (void)setEditing:(BOOL)editing animated:(BOOL)animated
 {
     [super setEditing:editing animated:animated];
@@ -723,11 +2759,19 @@ const NSInteger SWCellRevealPositionNone = 0xff;
         // In case the contentOffset methods on the revealScrollView are not available we will perform our layout manualy.
         // See _setRevealLocation: implementation
         _revealLayoutView = (id)[self.contentView superview];
+        [self _updateRevealOffsetViews];
+        
+        // Create a view to hold our custom utility views the first time we get here, then insert it into the cell hierarchy
+        if ( _utilityContentView == nil )
+        {
+            _utilityContentView = [[SWUtilityContentView alloc] initWithRevealTableViewCell:self frame:self.bounds];
+            [_utilityContentView setAutoresizingMask:UIViewAutoresizingFlexibleWidth|UIViewAutoresizingFlexibleHeight];
+            [_utilityContentView setLayerBacksItems:_layoutsButtonItemsUsingLayers];
+            [_utilityContentView setLayoutStrategy:_layoutStrategy];
+        }
         
-        // Create a view to hold our custom utility views and insert it into the cell hierarchy
-        _utilityContentView = [[SWUtilityContentView alloc] initWithRevealTableViewCell:self frame:self.bounds];
-        [_utilityContentView setAutoresizingMask:UIViewAutoresizingFlexibleWidth|UIViewAutoresizingFlexibleHeight];
         [_revealLayoutView insertSubview:_utilityContentView atIndex:0];
+        NSAssert( [self _utilityContentViewCount] == 1, @"A SWRevealTableViewCell must hold exactly one utility content view" );
     
         // Force the initial reveal position to the developer provided value
         SWCellRevealPosition initialPosition = _frontViewPosition;
@@ -736,17 +2780,55 @@ const NSInteger SWCellRevealPositionNone = 0xff;
         _rightViewPosition = SWCellRevealPositionNone;
         
         // Finally, set the actual position
-        [self _setRevealPosition:initialPosition withDuration:0.0];
+        if ( _restoresRevealPosition )
+            [self _restoreRevealPositionNow:initialPosition];
+        else
+            [self _setRevealPosition:initialPosition withDuration:0.0];
     }
     else
     {
+        // Return our utility views to the pool, they will be deployed again when we get back to a window
+        [self _invalidatePanDisplayLink];
+        [_utilityContentView setRasterizesItems:NO];
+        [_utilityContentView undeployRightItems];
+        [_utilityContentView undeployLeftItems];
         [_utilityContentView resetButtonItems];  // this will prevent retain cycles
     }
 }
 
 
+- (NSInteger)_utilityContentViewCount
+{
+    NSInteger count = 0;
+    for ( UIView *view in _revealLayoutView.subviews )
+    {
+        if ( [view isKindOfClass:[SWUtilityContentView class]] )
+            count += 1;
+    }
+    return count;
+}
+
+
 #pragma mark - Properties
 
+- (void)setDelegate:(id<SWRevealTableViewCellDelegate>)delegate
+{
+    _delegate = delegate;
+    
+    // we check for optional methods only once, hot paths just test the flags
+    _delegateFlags.panGestureBegan = [delegate respondsToSelector:@selector(revealTableViewCellPanGestureBegan:)];
+    _delegateFlags.panGestureBeganFromLocation = [delegate respondsToSelector:@selector(revealTableViewCell:panGestureBeganFromLocation:progress:)];
+    _delegateFlags.panGestureMovedToLocation = [delegate respondsToSelector:@selector(revealTableViewCell:panGestureMovedToLocation:progress:)];
+    _delegateFlags.panGestureEndedToLocation = [delegate respondsToSelector:@selector(revealTableViewCell:panGestureEndedToLocation:progress:)];
+    _delegateFlags.panGestureEnded = [delegate respondsToSelector:@selector(revealTableViewCellPanGestureEnded:)];
+    _delegateFlags.animateToPosition = [delegate respondsToSelector:@selector(revealTableViewCell:animateToPosition:)];
+    _delegateFlags.willMoveToPosition = [delegate respondsToSelector:@selector(revealTableViewCell:willMoveToPosition:)];
+    _delegateFlags.didMoveToPosition = [delegate respondsToSelector:@selector(revealTableViewCell:didMoveToPosition:)];
+    _delegateFlags.panGestureShouldRecognizeSimultaneously = [delegate respondsToSelector:@selector(revealTableViewCell:panGestureRecognizerShouldRecognizeSimultaneouslyWithGestureRecognizer:)];
+    _delegateFlags.panGestureShouldBegin = [delegate respondsToSelector:@selector(revealTableViewCellPanGestureShouldBegin:)];
+}
+
+
 - (NSArray *)rightCellButtonItems
 {
     return _utilityContentView.rightButtonItems;
@@ -772,6 +2854,7 @@ const NSInteger SWCellRevealPositionNone = 0xff;
         _frontViewPosition = revealPosition;
         _leftViewPosition = revealPosition;
         _rightViewPosition = revealPosition;
+        _restoresRevealPosition = NO;
         return;
     }
     
@@ -779,12 +2862,219 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 }
 
 
+- (void)restoreRevealPosition:(SWCellRevealPosition)revealPosition
+{
+    if ( ![self window] )
+    {
+        // the position will be applied by didMoveToWindow
+        _frontViewPosition = revealPosition;
+        _leftViewPosition = revealPosition;
+        _rightViewPosition = revealPosition;
+        _restoresRevealPosition = YES;
+        return;
+    }
+    
+    // do not mess with an ongoing animation or gesture, just get in the queue
+    if ( _requestQueue.count > 0 )
+    {
+        [self _dispatchSetRevealPosition:revealPosition animated:NO];
+        return;
+    }
+    
+    [self _restoreRevealPositionNow:revealPosition];
+}
+
+
+- (void)reloadButtonItemsAnimated:(BOOL)animated
+{
+    // cells out of a window discard their items, they will be asked again when needed
+    if ( ![self window] )
+        return;
+    
+    // do not mess with an ongoing animation or gesture, just get in the queue
+    SWRevealRequest request = { SWRevealRequestKindReloadItems, _frontViewPosition, animated };
+    [self _enqueueRequest:request];
+}
+
+
 - (void)resetCellAnimated:(BOOL)animated
 {
     [self setRevealPosition:SWCellRevealPositionCenter animated:animated];
 }
 
 
++ (void)setRevealPosition:(SWCellRevealPosition)revealPosition forCells:(id<NSFastEnumeration>)cells animated:(BOOL)animated
+    completion:(void (^)(void))completion
+{
+    NSMutableArray *transitionCompletions = [NSMutableArray array];
+    NSMutableArray *transitionCells = [NSMutableArray array];
+    NSTimeInterval duration = 0.0;
+    
+    // deployments and willMove notifications for all cells happen here, before any layout
+    for ( SWRevealTableViewCell *cell in cells )
+    {
+        // cells off screen or busy with a request just get the position on their own
+        if ( ![cell window] || cell->_requestQueue.count > 0 )
+        {
+            [cell setRevealPosition:revealPosition animated:animated];
+            continue;
+        }
+        
+        // hold the cell queue like a gesture does, so any forthcoming requests are scheduled after the batch
+        SWRevealRequest request = { SWRevealRequestKindGesture, cell->_frontViewPosition, NO };
+        [cell _enqueueRequest:request];
+        
+        [transitionCompletions addObject:[cell _revealTransitionCompletionForNewPosition:revealPosition]];
+        [transitionCells addObject:cell];
+        duration = MAX(duration, cell.revealAnimationDuration);
+    }
+    
+    // one layout pass for all cells, inside a single animation block if animated
+    BOOL animates = animated && transitionCells.count > 0 && duration > 0.0;
+    void (^animations)() = ^()
+    {
+        for ( SWRevealTableViewCell *cell in transitionCells )
+            [cell _layoutForRevealTransitionAnimated:animates];
+    };
+    
+    if ( animates )
+    {
+        // each cell can still be interrupted by a gesture on its own, in which case its completion is performed early
+        NSMutableArray *interruptibleCompletions = [NSMutableArray array];
+        NSInteger count = transitionCells.count;
+        for ( NSInteger i=0 ; i<count ; i++ )
+        {
+            SWRevealTableViewCell *cell = [transitionCells objectAtIndex:i];
+            [interruptibleCompletions addObject:[cell _interruptibleRevealCompletion:[transitionCompletions objectAtIndex:i]]];
+        }
+        
+        [UIView animateWithDuration:duration delay:0 usingSpringWithDamping:1 initialSpringVelocity:1/duration
+        options:UIViewAnimationOptionAllowUserInteraction animations:animations completion:^(BOOL finished)
+        {
+            for ( void (^transitionCompletion)(BOOL) in interruptibleCompletions )
+                transitionCompletion(finished);
+            
+            if ( completion )
+                completion();
+        }];
+    }
+    else
+    {
+        animations();
+        
+        for ( void (^transitionCompletion)(BOOL) in transitionCompletions )
+            transitionCompletion(YES);
+        
+        if ( completion )
+            completion();
+    }
+}
+
+
+- (void)setRevealsUsingTransforms:(BOOL)revealsUsingTransforms
+{
+    if ( _revealsUsingTransforms == revealsUsingTransforms )
+        return;
+    
+    [self _resetRevealTransforms];
+    
+    _revealsUsingTransforms = revealsUsingTransforms;
+    [self setNeedsLayout];
+}
+
+
+- (void)setLayoutsButtonItemsUsingLayers:(BOOL)layoutsButtonItemsUsingLayers
+{
+    _layoutsButtonItemsUsingLayers = layoutsButtonItemsUsingLayers;
+    [_utilityContentView setLayerBacksItems:layoutsButtonItemsUsingLayers];
+    [self setNeedsLayout];
+}
+
+
+- (void)setLayoutStrategy:(id<SWRevealLayoutStrategy>)layoutStrategy
+{
+    _layoutStrategy = layoutStrategy;
+    
+    // optional methods are resolved now, not while laying out
+    _overdrawDamperWidth = 80;
+    if ( [layoutStrategy respondsToSelector:@selector(overdrawDamperWidth)] )
+        _overdrawDamperWidth = [layoutStrategy overdrawDamperWidth];
+    
+    [_utilityContentView setLayoutStrategy:layoutStrategy];
+    [self setNeedsLayout];
+}
+
+
+- (void)setPanDirectionThreshold:(CGFloat)panDirectionThreshold
+{
+    _panDirectionThreshold = panDirectionThreshold;
+    [_panGestureRecognizer setDirectionThreshold:panDirectionThreshold];
+}
+
+
+- (void)setPanDirectionMaximumAngle:(CGFloat)panDirectionMaximumAngle
+{
+    _panDirectionMaximumAngle = panDirectionMaximumAngle;
+    [_panGestureRecognizer setDirectionMaximumAngle:panDirectionMaximumAngle];
+}
+
+
+- (void)setUtilityViewPool:(SWUtilityViewPool *)utilityViewPool
+{
+    _utilityViewPool = utilityViewPool ? utilityViewPool : [SWUtilityViewPool sharedPool];
+}
+
+
+- (void)prepareButtonItemsIfNeeded
+{
+    if ( _prewarmScheduled )
+        return;
+    
+    // we do the actual work when the run loop is idle, the default mode does not run while a scroll view is tracking
+    _prewarmScheduled = YES;
+    [self performSelector:@selector(_prepareButtonItemsNow) withObject:nil afterDelay:0 inModes:@[NSDefaultRunLoopMode]];
+}
+
+
+- (void)_prepareButtonItemsNow
+{
+    _prewarmScheduled = NO;
+    
+    // only a centered cell at rest can be safely prewarmed,
+    // also, cells out of a window discard their items, so there is no point on building them
+    if ( self.window == nil || _frontViewPosition != SWCellRevealPositionCenter || _requestQueue.count > 0 )
+        return;
+    
+    [_utilityContentView prewarmItems];
+    
+    // prewarmed items that do not get revealed for a while are released
+    if ( _idleResourceTimeout > 0 )
+        [self _scheduleIdleResourceRelease];
+}
+
+
+// The scheduled release does not retain us, so cells do not outlive their table view waiting for it.
+// A later schedule or cancel bumps the revision, so only the latest scheduled release is performed
+- (void)_scheduleIdleResourceRelease
+{
+    NSUInteger revision = ++_idleResourceRevision;
+    __weak SWRevealTableViewCell *weakSelf = self;
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_idleResourceTimeout*NSEC_PER_SEC)), dispatch_get_main_queue(), ^
+    {
+        SWRevealTableViewCell *cell = weakSelf;
+        if ( cell && cell->_idleResourceRevision == revision )
+            [cell releaseIdleResources];
+    });
+}
+
+
+- (void)_cancelIdleResourceRelease
+{
+    _idleResourceRevision += 1;
+}
+
+
 - (void)setAllowsRevealInEditMode:(BOOL)allowsRevealInEditMode
 {
     _allowsRevealInEditMode = allowsRevealInEditMode;
@@ -793,6 +3083,12 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 }
 
 
+- (BOOL)_isPerformingRevealAnimations
+{
+    return _performsRevealAnimations;
+}
+
+
 #pragma mark - Reveal Location
 
 - (void)_setRevealLocation:(CGFloat)xLocation
@@ -800,18 +3096,31 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     // set the new reveal location
     _revealLocation = xLocation;
     
-    // compensate our utilityContentView for cell layout comming next.
+    BOOL scrollsRevealLayoutView = [_revealLayoutView respondsToSelector:@selector(setContentOffset:)];
+    BOOL usesTransforms = _revealsUsingTransforms && !scrollsRevealLayoutView;
+    
+    // compensate our utilityContentView for the scrolling comming next.
+    // Otherwise the utilityContentView is not offseted along with its siblings, so it just stays in place
     CGRect utilityFrame = self.bounds;
     utilityFrame.size.height -= 0.5;
-    utilityFrame.origin.x = -xLocation;
+    utilityFrame.origin.x = scrollsRevealLayoutView ? -xLocation : 0;
     [_utilityContentView setFrame:utilityFrame];
     
-    if ( [_revealLayoutView respondsToSelector:@selector(setContentOffset:)] )
+    if ( scrollsRevealLayoutView )
     {
         // We have an underlying UIScrollView supporting our views (iOS7). We just set its contentOfset,
         // Apple implementation takes care of all the required layout code.
         [(UIScrollView*)_revealLayoutView setContentOffset:CGPointMake(-xLocation,0)];
     }
+    
+    else if ( usesTransforms )
+    {
+        // We translate the views that we keep in _revealOffsetViews. Frames are not touched,
+        // so no layout is involved here and cell subview frames remain the ones computed by Apple implementation.
+        CGAffineTransform transform = CGAffineTransformMakeTranslation(xLocation, 0);
+        for ( UIView *view in _revealOffsetViews )
+            [view setTransform:transform];
+    }
 
     else
     {
@@ -820,62 +3129,307 @@ const NSInteger SWCellRevealPositionNone = 0xff;
         // We first call super layoutSubviews to get base cell subview frames from Apple implementation.
         [super layoutSubviews];
         
-        // Now we apply our custom layout offset
-        for ( UIView *view in _revealLayoutView.subviews )
+        // Now we apply our custom layout offset to the contentView and its siblings, see _updateRevealOffsetViews
+        for ( UIView *view in _revealOffsetViews )
         {
-            // One of the siblings of the cell contentView is the cell's separatorView.
-            // We do not want to apply our custom layout offseting to that particular view, so we skip that view based on its class name.
-            // This is of course hacky and may break in the future. However since we choose to apply our layout directly to the cell, as oposed to
-            // the cell's contentView we do not have other choice than filtering this here.
-            // If this code breaks on a future iOS release it will be very easy to fix anyway.
-            {
-                if ( [NSStringFromClass([view class]) rangeOfString:@"Separator"].length > 0 )
-                    continue;
-            }
-            
             view.frame = CGRectOffset(view.frame, xLocation, 0 );
         }
     }
 }
 
 
+#pragma mark - Reveal offset views
+
+// Returns whether the view must be offseted along with the cell contentView
+- (BOOL)_wantsRevealOffsetForView:(UIView*)view
+{
+    // Our utilityContentView is placed below the cell content and must stay in place
+    if ( view == _utilityContentView )
+        return NO;
+    
+    // One of the siblings of the cell contentView is the cell's separatorView.
+    // We do not want to apply our custom layout offseting to that particular view, so we skip that view based on its class name.
+    // This is of course hacky and may break in the future. However since we choose to apply our layout directly to the cell, as oposed to
+    // the cell's contentView we do not have other choice than filtering this here.
+    // If this code breaks on a future iOS release it will be very easy to fix anyway.
+    if ( [NSStringFromClass([view class]) rangeOfString:@"Separator"].length > 0 )
+        return NO;
+    
+    return YES;
+}
+
+
+// Determines the views that must be offseted on location changes, this is the cell contentView and its siblings.
+// We only do this when the reveal layout view is set, later changes are tracked through didAddSubview: and willRemoveSubview:
+- (void)_updateRevealOffsetViews
+{
+    if ( _revealOffsetViews == nil )
+        _revealOffsetViews = [NSMutableArray array];
+    
+    if ( _revealsUsingTransforms )
+        [self _resetRevealTransforms];
+    
+    [_revealOffsetViews removeAllObjects];
+    
+    for ( UIView *view in _revealLayoutView.subviews )
+    {
+        if ( [self _wantsRevealOffsetForView:view] )
+            [_revealOffsetViews addObject:view];
+    }
+}
+
+
+- (void)didAddSubview:(UIView *)subview
+{
+    [super didAddSubview:subview];
+    
+    // subview reordering also gets here, so we must check whether we already have the view
+    if ( _revealLayoutView == self && [_revealOffsetViews indexOfObjectIdenticalTo:subview] == NSNotFound )
+    {
+        if ( [self _wantsRevealOffsetForView:subview] )
+            [_revealOffsetViews addObject:subview];
+    }
+}
+
+
+- (void)willRemoveSubview:(UIView *)subview
+{
+    [super willRemoveSubview:subview];
+    
+    NSUInteger index = [_revealOffsetViews indexOfObjectIdenticalTo:subview];
+    if ( index != NSNotFound )
+    {
+        if ( _revealsUsingTransforms )
+            [subview setTransform:CGAffineTransformIdentity];
+        
+        [_revealOffsetViews removeObjectAtIndex:index];
+    }
+}
+
+
+- (void)_resetRevealTransforms
+{
+    for ( UIView *view in _revealOffsetViews )
+        [view setTransform:CGAffineTransformIdentity];
+}
+
+
 #pragma mark - Button Items
 
+// Item arrays for cells providing a signature are kept in these process wide caches, one for each side.
+// NSCache will evict them on memory pressure, we also bound the number of kept arrays
+static SWCountedCache *_sharedButtonItemsCache(BOOL left)
+{
+    static SWCountedCache *leftItemsCache = nil;
+    static SWCountedCache *rightItemsCache = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        leftItemsCache = [[SWCountedCache alloc] init];
+        [leftItemsCache setCountLimit:32];
+        rightItemsCache = [[SWCountedCache alloc] init];
+        [rightItemsCache setCountLimit:32];
+    });
+    return left ? leftItemsCache : rightItemsCache;
+}
+
+
+// Items cached for a signature are shared by all cells, so each cell binds its own copies of them
+static NSArray *_unboundCopiesOfItems(NSArray *items)
+{
+    NSMutableArray *copies = [NSMutableArray arrayWithCapacity:items.count];
+    for ( SWCellButtonItem *item in items )
+        [copies addObject:[item _unboundCopy]];
+    
+    return copies;
+}
+
+
++ (void)purgeButtonItemsCache
+{
+    [_sharedButtonItemsCache(YES) removeAllObjects];
+    [_sharedButtonItemsCache(NO) removeAllObjects];
+}
+
+
+#pragma mark - Resources
+
+- (SWRevealResourceUsage*)resourceUsage
+{
+    NSUInteger itemCount = 0, utilityViewCount = 0;
+    [_utilityContentView getItemCount:&itemCount utilityViewCount:&utilityViewCount];
+    
+    SWRevealResourceUsage *usage = [[SWRevealResourceUsage alloc] init];
+    usage.itemCount = itemCount;
+    usage.utilityViewCount = utilityViewCount;
+    return usage;
+}
+
+
++ (SWRevealResourceUsage*)globalResourceUsage
+{
+    SWRevealResourceUsage *usage = [[SWRevealResourceUsage alloc] init];
+    
+    for ( SWUtilityContentView *contentView in _allUtilityContentViews() )
+    {
+        NSUInteger itemCount = 0, utilityViewCount = 0;
+        [contentView getItemCount:&itemCount utilityViewCount:&utilityViewCount];
+        usage.itemCount += itemCount;
+        usage.utilityViewCount += utilityViewCount;
+    }
+    
+    for ( SWUtilityViewPool *pool in _allUtilityViewPools() )
+        usage.pooledViewCount += pool.pooledViewCount;
+    
+    usage.cachedImageCount = _colorImagesCache().count + _decodedImagesCache().count + _tintedImagesCache().count +
+        _placeholderImagesCache().count;
+    usage.cachedItemArrayCount = _sharedButtonItemsCache(YES).count + _sharedButtonItemsCache(NO).count;
+    return usage;
+}
+
+
+- (void)releaseIdleResources
+{
+    [self _cancelIdleResourceRelease];
+    
+    // revealed cells, or cells in the middle of a request or gesture, need their items
+    if ( _frontViewPosition != SWCellRevealPositionCenter || _requestQueue.count > 0 )
+        return;
+    
+    // this gets rid of prewarmed items and views, along with the handlers they retain
+    [_utilityContentView resetButtonItems];
+}
+
+
++ (void)releaseAllIdleResources
+{
+    // cells may go away while we release their resources, so we enumerate a copy
+    for ( SWUtilityContentView *contentView in [_allUtilityContentViews() allObjects] )
+        [contentView.revealTableViewCell releaseIdleResources];
+    
+    [self purgeButtonItemsCache];
+    [_colorImagesCache() removeAllObjects];
+    [_decodedImagesCache() removeAllObjects];
+    [_tintedImagesCache() removeAllObjects];
+    [_placeholderImagesCache() removeAllObjects];
+    
+    for ( SWUtilityViewPool *pool in [_allUtilityViewPools() allObjects] )
+        [pool purge];
+}
+
+
 - (NSArray*)_getLeftButtonItems
 {
+    SWSignpostBegin("GetLeftButtonItems");
     NSArray *leftItems = nil;
     
     if ( _dataSource )
-        leftItems = [self _preparedItems:[_dataSource leftButtonItemsInRevealTableViewCell:self]];
+    {
+        // first look for items already built for the same signature
+        id signature = [self _buttonItemsSignature];
+        NSCache *cache = signature ? _sharedButtonItemsCache(YES) : nil;
+        
+        leftItems = [cache objectForKey:signature];
+        if ( leftItems == nil )
+        {
+            leftItems = [[_dataSource leftButtonItemsInRevealTableViewCell:self] copy];
+            if ( leftItems ) [cache setObject:leftItems forKey:signature];
+            
+            if ( _gestureMetrics ) _gestureMetrics.builtItemCount += leftItems.count;
+        }
+        
+        if ( cache && leftItems ) leftItems = _unboundCopiesOfItems(leftItems);
+        
+        leftItems = [self _preparedItems:leftItems];
+    }
         
     // we will return nil if dataSource has not been set yet, some array (maybe empty) otherwise
     // once we got an array the data source is never asked again
+    SWSignpostEnd("GetLeftButtonItems");
     return leftItems;
 }
 
 
 - (NSArray*)_getRightButtonItems
 {
+    SWSignpostBegin("GetRightButtonItems");
     NSArray *rightItems = nil;
     
     if ( _dataSource )
-        rightItems = [self _preparedItems:[_dataSource rightButtonItemsInRevealTableViewCell:self]];
+    {
+        // first look for items already built for the same signature
+        id signature = [self _buttonItemsSignature];
+        NSCache *cache = signature ? _sharedButtonItemsCache(NO) : nil;
+        
+        rightItems = [cache objectForKey:signature];
+        if ( rightItems == nil )
+        {
+            rightItems = [[_dataSource rightButtonItemsInRevealTableViewCell:self] copy];
+            if ( rightItems ) [cache setObject:rightItems forKey:signature];
+            
+            if ( _gestureMetrics ) _gestureMetrics.builtItemCount += rightItems.count;
+        }
+        
+        if ( cache && rightItems ) rightItems = _unboundCopiesOfItems(rightItems);
+        
+        rightItems = [self _preparedItems:rightItems];
+    }
 
     // we will return nil if dataSource has not been set yet, some array (maybe empty) otherwise
     // once we got an array the data source is never asked again
+    SWSignpostEnd("GetRightButtonItems");
     return rightItems;
 }
 
 
+- (id)_buttonItemsSignature
+{
+    if ( [_dataSource respondsToSelector:@selector(buttonItemsSignatureForRevealTableViewCell:)] )
+        return [_dataSource buttonItemsSignatureForRevealTableViewCell:self];
+    
+    return nil;
+}
+
+
+// Items are only requested for the side being revealed. The following methods are used to check for items
+// before we know we will actually deploy them, so we give a chance to the data source to answer without building the items
+- (BOOL)_hasLeftButtonItems
+{
+    if ( _utilityContentView.leftButtonItems == nil && [_dataSource respondsToSelector:@selector(revealTableViewCellHasLeftButtonItems:)] )
+        return [_dataSource revealTableViewCellHasLeftButtonItems:self];
+    
+    return _utilityContentView.leftCount > 0;
+}
+
+
+- (BOOL)_hasRightButtonItems
+{
+    if ( _utilityContentView.rightButtonItems == nil && [_dataSource respondsToSelector:@selector(revealTableViewCellHasRightButtonItems:)] )
+        return [_dataSource revealTableViewCellHasRightButtonItems:self];
+    
+    return _utilityContentView.rightCount > 0;
+}
+
+
+- (void)_updateViewForButtonItem:(SWCellButtonItem*)item
+{
+    [_utilityContentView updateViewForItem:item];
+}
+
+
 - (NSArray*)_preparedItems:(NSArray*)itemsArray
 {
     for ( SWCellButtonItem *item in itemsArray )
+    {
         item.view = _utilityContentView;
+        item.cell = self;
+    }
     
     return [itemsArray copy];
 }
 
 
+
 #pragma mark - Symmetry
 
 - (void)_getAdjustedRevealPosition:(SWCellRevealPosition*)revealPosition forSymmetry:(int)symmetry
@@ -898,13 +3452,13 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 
 - (void)_notifyPanGestureBegan
 {
-    if ( [_delegate respondsToSelector:@selector(revealTableViewCellPanGestureBegan:)] )
+    if ( _delegateFlags.panGestureBegan )
         [_delegate revealTableViewCellPanGestureBegan:self];
     
     CGFloat xLocation, dragProgress;
     [self _getDragLocation:&xLocation progress:&dragProgress];
 
-    if ( [_delegate respondsToSelector:@selector(revealTableViewCell:panGestureBeganFromLocation:progress:)] )
+    if ( _delegateFlags.panGestureBeganFromLocation )
         [_delegate revealTableViewCell:self panGestureBeganFromLocation:xLocation progress:dragProgress];
 }
 
@@ -914,7 +3468,7 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     CGFloat xLocation, dragProgress;
     [self _getDragLocation:&xLocation progress:&dragProgress];
     
-    if ( [_delegate respondsToSelector:@selector(revealTableViewCell:panGestureMovedToLocation:progress:)] )
+    if ( _delegateFlags.panGestureMovedToLocation )
         [_delegate revealTableViewCell:self panGestureMovedToLocation:xLocation progress:dragProgress];
 }
 
@@ -924,41 +3478,90 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     CGFloat xLocation, dragProgress;
     [self _getDragLocation:&xLocation progress:&dragProgress];
     
-    if ( [_delegate respondsToSelector:@selector(revealTableViewCell:panGestureEndedToLocation:progress:)] )
+    if ( _delegateFlags.panGestureEndedToLocation )
         [_delegate revealTableViewCell:self panGestureEndedToLocation:xLocation progress:dragProgress];
     
-    if ( [_delegate respondsToSelector:@selector(revealTableViewCellPanGestureEnded:)] )
+    if ( _delegateFlags.panGestureEnded )
         [_delegate revealTableViewCellPanGestureEnded:self];
 }
 
 
-#pragma mark - Deferred block execution queue
-
-// Define a convenience macro to enqueue single statements
-#define _enqueue(code) [self _enqueueBlock:^{code;}];
+#pragma mark - Deferred request queue
 
-// Defers the execution of the passed in block until a paired _dequeue call is received,
-// or executes the block right away if no pending requests are present.
-- (void)_enqueueBlock:(void (^)(void))block
+// Defers the execution of the passed in request until a paired _dequeue call is received,
+// or executes the request right away if no pending requests are present.
+// Position requests received while another request is in process replace any pending position request, so only the latest
+// target position is kept and it is performed after the other pending requests. A reload request is dropped if a reload is already
+// pending, as it will get the latest items anyway. Other requests are never replaced or dropped. Nothing gets allocated here.
+- (void)_enqueueRequest:(SWRevealRequest)request
 {
-    [_animationQueue insertObject:block atIndex:0];
-    if ( _animationQueue.count == 1)
+    SWRevealRequestQueue *queue = &_requestQueue;
+    
+    // drop pending position requests, the new one supersedes them
+    if ( request.kind == SWRevealRequestKindPosition )
+    {
+        for ( NSInteger i=queue->count-1 ; i>0 ; i-- )
+        {
+            if ( _requestQueueAt(queue, i)->kind == SWRevealRequestKindPosition )
+                _requestQueueRemove(queue, i);
+        }
+    }
+    
+    // coalesce with a pending reload request, if any. A reload in process already got its items so it does not count
+    if ( request.kind == SWRevealRequestKindReloadItems )
     {
-        block();
+        for ( NSInteger i=1 ; i<queue->count ; i++ )
+        {
+            SWRevealRequest *pending = _requestQueueAt(queue, i);
+            if ( pending->kind == SWRevealRequestKindReloadItems )
+            {
+                pending->animated = pending->animated || request.animated;
+                return;
+            }
+        }
     }
+    
+    // we never grow, this can not happen given the coalescing above but we would rather lose the new request than overrun the queue
+    NSAssert( queue->count < SWRevealRequestQueueCapacity, @"Request queue full" );
+    if ( queue->count == SWRevealRequestQueueCapacity )
+        return;
+    
+    _requestQueueInsert(queue, queue->count, request);
+    
+    if ( queue->count == 1 )
+        [self _performRequest:request];
 }
 
-// Removes the top most block in the queue and executes the following one if any.
-// Calls to this method must be paired with calls to _enqueueBlock, particularly it may be called
-// from within a block passed to _enqueueBlock to remove itself when done with animations.  
+// Removes the request in process from the queue and executes the following one if any.
+// Calls to this method must be paired with calls to _enqueueRequest, particularly it is called
+// on completion of the position change performed by a request.
 - (void)_dequeue
 {
-    [_animationQueue removeLastObject];
+    SWRevealRequestQueue *queue = &_requestQueue;
+    
+    if ( queue->count == 0 )
+        return;
+    
+    queue->head = (queue->head + 1) % SWRevealRequestQueueCapacity;
+    queue->count -= 1;
+    
+    if ( queue->count > 0 )
+        [self _performRequest:*_requestQueueAt(queue, 0)];
+}
+
 
-    if ( _animationQueue.count > 0 )
+- (void)_performRequest:(SWRevealRequest)request
+{
+    // gesture requests just hold the queue until the gesture is done
+    if ( request.kind == SWRevealRequestKindPosition )
+    {
+        NSTimeInterval duration = request.animated ? _revealAnimationDuration : 0.0;
+        [self _setRevealPosition:request.position withDuration:duration];
+    }
+    
+    else if ( request.kind == SWRevealRequestKindReloadItems )
     {
-        void (^block)(void) = [_animationQueue lastObject];
-        block();
+        [self _reloadButtonItemsNowAnimated:request.animated];
     }
 }
 
@@ -967,9 +3570,8 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 
 - (void)_dispatchSetRevealPosition:(SWCellRevealPosition)revealPosition animated:(BOOL)animated
 {
-    NSTimeInterval duration = animated ? _revealAnimationDuration : 0.0;
-    __weak SWRevealTableViewCell *theSelf = self;
-    _enqueue( [theSelf _setRevealPosition:revealPosition withDuration:duration] );
+    SWRevealRequest request = { SWRevealRequestKindPosition, revealPosition, animated };
+    [self _enqueueRequest:request];
 }
 
 
@@ -978,21 +3580,46 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 // Primitive method for view controller deployment and animated layout to the given position.
 - (void)_setRevealPosition:(SWCellRevealPosition)newPosition withDuration:(NSTimeInterval)duration
 {
-    void (^frontDeploymentCompletion)() = [self _frontDeploymentForNewRevealPosition:newPosition];
-    void (^leftDeploymentCompletion)() = [self _leftDeploymentForNewRevealPosition:newPosition];
-    void (^rightDeploymentCompletion)() = [self _rightDeploymentForNewRevealPosition:newPosition];
+    [self _setRevealPosition:newPosition withDuration:duration initialSpringVelocity:(duration > 0.0f ? 1/duration : 0)];
+}
+
+
+// The springVelocity parameter is relative to the animation journey, as for UIView spring animations
+- (void)_setRevealPosition:(SWCellRevealPosition)newPosition withDuration:(NSTimeInterval)duration initialSpringVelocity:(CGFloat)springVelocity
+{
+    SWSignpostBegin("SetRevealPosition");
+    
+    void (^completion)(BOOL) = [self _revealTransitionCompletionForNewPosition:newPosition];
     
     void (^animations)() = ^()
     {
-        // We layout the views and call the delegate, which will
-        // occur inside of an animation block if any animated transition is being performed
+        [self _layoutForRevealTransitionAnimated:(duration > 0.0f)];
+    };
+    
+    if ( duration > 0.0f )
+    {
+//        [UIView animateWithDuration:duration delay:0.0
+//        options:UIViewAnimationOptionCurveEaseOut animations:animations completion:completion];
         
-        CGFloat xLocation = [_utilityContentView frontLocationForPosition:_frontViewPosition];
-        [self layoutForLocation:xLocation];
+        [UIView animateWithDuration:_revealAnimationDuration delay:0 usingSpringWithDamping:1 initialSpringVelocity:springVelocity
+        options:UIViewAnimationOptionAllowUserInteraction animations:animations completion:[self _interruptibleRevealCompletion:completion]];
+    }
+    else
+    {
+        animations();
+        completion(YES);
+    }
     
-        if ([_delegate respondsToSelector:@selector(revealTableViewCell:animateToPosition:)])
-            [_delegate revealTableViewCell:self animateToPosition:_frontViewPosition];
-    };
+    SWSignpostEnd("SetRevealPosition");
+}
+
+// Performs view deployments for the new position and returns a block that must be invoked on animation completion
+// in order to finish the transition
+- (void (^)(BOOL))_revealTransitionCompletionForNewPosition:(SWCellRevealPosition)newPosition
+{
+    void (^frontDeploymentCompletion)() = [self _frontDeploymentForNewRevealPosition:newPosition];
+    void (^leftDeploymentCompletion)() = [self _leftDeploymentForNewRevealPosition:newPosition];
+    void (^rightDeploymentCompletion)() = [self _rightDeploymentForNewRevealPosition:newPosition];
     
     void (^completion)(BOOL) = ^(BOOL finished)
     {
@@ -1000,6 +3627,9 @@ const NSInteger SWCellRevealPositionNone = 0xff;
         rightDeploymentCompletion();
         frontDeploymentCompletion();
         
+        // live buttons are back once we settle
+        [_utilityContentView setRasterizesItems:NO];
+        
         // next time we want to get items from the datasource, so we may reset current items now
         if ( newPosition == SWCellRevealPositionCenter )
             [_utilityContentView resetButtonItems];
@@ -1007,13 +3637,113 @@ const NSInteger SWCellRevealPositionNone = 0xff;
         [self _dequeue];
     };
     
-    if ( duration > 0.0f )
+    return completion;
+}
+
+// We layout the views and call the delegate, which will
+// occur inside of an animation block if any animated transition is being performed
+- (void)_layoutForRevealTransitionAnimated:(BOOL)animated
+{
+    _performsRevealAnimations = animated;
+    
+    CGFloat xLocation = [_utilityContentView frontLocationForPosition:_frontViewPosition];
+    [self layoutForLocation:xLocation];
+
+    if (_delegateFlags.animateToPosition)
+        [_delegate revealTableViewCell:self animateToPosition:_frontViewPosition];
+    
+    _performsRevealAnimations = NO;
+}
+
+// We keep the completion around so the animation can be interrupted by a gesture, in which case it will be
+// performed early by _interruptRevealAnimationAtLocation: and the revision will not match anymore.
+// Returns the block to be invoked on actual animation completion
+- (void (^)(BOOL))_interruptibleRevealCompletion:(void (^)(BOOL))completion
+{
+    NSUInteger revision = ++_revealAnimationRevision;
+    _revealAnimationCompletion = completion;
+    
+    return ^(BOOL finished)
     {
-//        [UIView animateWithDuration:duration delay:0.0
-//        options:UIViewAnimationOptionCurveEaseOut animations:animations completion:completion];
+        if ( revision != _revealAnimationRevision )
+            return;
+        
+        _revealAnimationCompletion = nil;
+        completion(finished);
+    };
+}
+
+// Silent counterpart of _setRevealPosition:withDuration: with zero duration. Utility views are deployed from the pool and laid out
+// in a single pass, no requests are enqueued, and neither the coordinator nor the delegate get notified
+- (void)_restoreRevealPositionNow:(SWCellRevealPosition)newPosition
+{
+    _restoresRevealPosition = NO;
+    
+    void (^leftDeploymentCompletion)() = [self _leftDeploymentForNewRevealPosition:newPosition];
+    void (^rightDeploymentCompletion)() = [self _rightDeploymentForNewRevealPosition:newPosition];
+    _frontViewPosition = [self _effectiveFrontPositionForPosition:newPosition];
+    
+    CGFloat xLocation = [_utilityContentView frontLocationForPosition:_frontViewPosition];
+    [self layoutForLocation:xLocation];
+    
+    leftDeploymentCompletion();
+    rightDeploymentCompletion();
+    
+    if ( _frontViewPosition == SWCellRevealPositionCenter )
+        [_utilityContentView resetButtonItems];
+}
+
+// Performs a SWRevealRequestKindReloadItems request. Item arrays are asked again for the sides that were already prepared,
+// and utility views are updated in place, then the front view is moved to the location for the new reveal width.
+// The request is dequeued on completion
+- (void)_reloadButtonItemsNowAnimated:(BOOL)animated
+{
+    // centered cells have nothing on screen, items will just be asked again when needed
+    if ( _frontViewPosition == SWCellRevealPositionCenter )
+    {
+        [_utilityContentView resetButtonItems];
+        [self _dequeue];
+        return;
+    }
+    
+    NSArray *leftItems = _utilityContentView.leftButtonItems ? [self _getLeftButtonItems] : nil;
+    NSArray *rightItems = _utilityContentView.rightButtonItems ? [self _getRightButtonItems] : nil;
+    NSMutableArray *insertedViews = [NSMutableArray array];
+    NSMutableArray *removedViews = [NSMutableArray array];
+    
+    [_utilityContentView reloadLeftItems:leftItems rightItems:rightItems location:_revealLocation
+        insertedViews:insertedViews removedViews:removedViews];
+    
+    if ( animated )
+        for ( UIView *view in insertedViews ) [view setAlpha:0];
+    
+    void (^animations)() = ^()
+    {
+        for ( UIView *view in insertedViews ) [view setAlpha:1];
+        for ( UIView *view in removedViews ) [view setAlpha:0];
+        
+        // the position does not change, so the delegate is not involved
+        _performsRevealAnimations = animated;
+        [self layoutForLocation:[_utilityContentView frontLocationForPosition:_frontViewPosition]];
+        _performsRevealAnimations = NO;
+    };
+    
+    void (^completion)(BOOL) = ^(BOOL finished)
+    {
+        SWUtilityViewPool *pool = _utilityViewPool;
+        for ( SWUtilityView *utilityView in removedViews ) [pool _enqueueUtilityView:utilityView];
+        
+        // no items left on the revealed side, get back to center the regular way so everyone gets notified
+        if ( [_utilityContentView frontLocationForPosition:_frontViewPosition] == 0 )
+            [self _dispatchSetRevealPosition:SWCellRevealPositionCenter animated:animated];
         
-        [UIView animateWithDuration:_revealAnimationDuration delay:0 usingSpringWithDamping:1 initialSpringVelocity:1/duration
-        options:0 animations:animations completion:completion];
+        [self _dequeue];
+    };
+    
+    if ( animated )
+    {
+        [UIView animateWithDuration:_revealAnimationDuration delay:0 usingSpringWithDamping:1 initialSpringVelocity:0
+        options:UIViewAnimationOptionAllowUserInteraction animations:animations completion:completion];
     }
     else
     {
@@ -1022,9 +3752,88 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     }
 }
 
+// Stops an ongoing reveal animation leaving views at their currently presented location, which is returned in xLocation.
+// Pending position requests are discarded as the gesture will decide the position, other pending requests are kept in order
+// behind a gesture request holding the queue. The animation completion is performed right away. Returns NO if there was no animation
+- (BOOL)_interruptRevealAnimationAtLocation:(CGFloat*)xLocation
+{
+    void (^completion)(BOOL) = _revealAnimationCompletion;
+    
+    if ( completion == nil )
+        return NO;
+    
+    *xLocation = [self _presentedRevealLocation];
+    
+    _revealAnimationCompletion = nil;
+    _revealAnimationRevision += 1;
+    
+    // drop pending position requests, and get a gesture request next to the request in process so
+    // the completion will not start any further animation
+    SWRevealRequestQueue *queue = &_requestQueue;
+    for ( NSInteger i=queue->count-1 ; i>0 ; i-- )
+    {
+        if ( _requestQueueAt(queue, i)->kind == SWRevealRequestKindPosition )
+            _requestQueueRemove(queue, i);
+    }
+    
+    SWRevealRequest request = { SWRevealRequestKindGesture, _frontViewPosition, NO };
+    _requestQueueInsert(queue, MIN(queue->count, 1), request);
+    
+    [self _removeRevealAnimations];
+    completion(NO);
+    
+    return YES;
+}
+
+
+// Returns the reveal location as currently presented on screen, which differs from _revealLocation during animations
+- (CGFloat)_presentedRevealLocation
+{
+    CGFloat xLocation = _revealLocation;
+    
+    if ( [_revealLayoutView respondsToSelector:@selector(setContentOffset:)] )
+    {
+        CALayer *layer = _revealLayoutView.layer;
+        CALayer *presentationLayer = [layer presentationLayer];
+        if ( presentationLayer )
+            xLocation -= presentationLayer.bounds.origin.x - layer.bounds.origin.x;
+    }
+    else
+    {
+        // the presentation layer frame accounts for both frame offsets and transforms
+        CALayer *layer = self.contentView.layer;
+        CALayer *presentationLayer = [layer presentationLayer];
+        if ( presentationLayer )
+            xLocation += presentationLayer.frame.origin.x - layer.frame.origin.x;
+    }
+    
+    return xLocation;
+}
+
+
+// Removes the animations added by layoutForLocation: inside an animation block
+- (void)_removeRevealAnimations
+{
+    if ( [_revealLayoutView respondsToSelector:@selector(setContentOffset:)] )
+        [_revealLayoutView.layer removeAllAnimations];
+    
+    for ( UIView *view in _revealOffsetViews )
+        [view.layer removeAllAnimations];
+    
+    [_utilityContentView.layer removeAllAnimations];
+    for ( UIView *utilityView in _utilityContentView.subviews )
+    {
+        [utilityView.layer removeAllAnimations];
+        for ( UIView *view in utilityView.subviews )
+            [view.layer removeAllAnimations];
+    }
+}
+
+
 // Deploy/Undeploy of the front view controller following the containment principles. Returns a block
 // that must be invoked on animation completion in order to finish deployment
-- (void (^)(void))_frontDeploymentForNewRevealPosition:(SWCellRevealPosition)newPosition
+// Returns the position the front view will actually get to for the requested position
+- (SWCellRevealPosition)_effectiveFrontPositionForPosition:(SWCellRevealPosition)newPosition
 {
     if ( ( newPosition < SWCellRevealPositionCenter && _utilityContentView.rightCount==0 ) ||
          ( newPosition > SWCellRevealPositionCenter && _utilityContentView.leftCount==0) )
@@ -1033,11 +3842,21 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     if ( !_allowsRevealInEditMode && self.editing )
         newPosition = SWCellRevealPositionCenter;
     
+    return newPosition;
+}
+
+
+- (void (^)(void))_frontDeploymentForNewRevealPosition:(SWCellRevealPosition)newPosition
+{
+    newPosition = [self _effectiveFrontPositionForPosition:newPosition];
+    
     BOOL positionIsChanging = (_frontViewPosition != newPosition);
     
     if ( positionIsChanging )
     {
-        if ( [_delegate respondsToSelector:@selector(revealTableViewCell:willMoveToPosition:)] )
+        [_coordinator _revealTableViewCell:self willMoveToPosition:newPosition];
+        
+        if ( _delegateFlags.willMoveToPosition )
             [_delegate revealTableViewCell:self willMoveToPosition:newPosition];
     }
     
@@ -1047,7 +3866,7 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     {
         if ( positionIsChanging )
         {
-            if ( [_delegate respondsToSelector:@selector(revealTableViewCell:didMoveToPosition:)] )
+            if ( _delegateFlags.didMoveToPosition )
                 [_delegate revealTableViewCell:self didMoveToPosition:newPosition];
         }
     };
@@ -1101,7 +3920,10 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 
 - (void (^)(void))_deploymentForRightItemsWithAppear:(BOOL)appear disappear:(BOOL)disappear
 {
+    CFTimeInterval startTime = _gestureMetrics ? CACurrentMediaTime() : 0;
+    
     if ( appear ) [_utilityContentView deployRightItems];
+    if ( appear && _gestureMetrics ) _gestureMetrics.deployDuration += CACurrentMediaTime()-startTime;
     if ( disappear ) return ^{ [_utilityContentView undeployRightItems]; };
     return ^{};
 }
@@ -1109,7 +3931,10 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 
 - (void (^)(void))_deploymentForLeftItemsWithAppear:(BOOL)appear disappear:(BOOL)disappear
 {
+    CFTimeInterval startTime = _gestureMetrics ? CACurrentMediaTime() : 0;
+    
     if ( appear ) [_utilityContentView deployLeftItems];
+    if ( appear && _gestureMetrics ) _gestureMetrics.deployDuration += CACurrentMediaTime()-startTime;
     if ( disappear ) return ^{ [_utilityContentView undeployLeftItems]; };
     return ^{};
 }
@@ -1119,6 +3944,11 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 
 - (void)layoutSubviews
 {
+    // frames of translated views are undefined while they have a transform, so we get them back to
+    // identity before Apple implementation lays them out
+    if ( _revealsUsingTransforms )
+        [self _resetRevealTransforms];
+    
     [super layoutSubviews];
     [self layoutForLocation:_revealLocation];
 }
@@ -1126,24 +3956,28 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 
 - (void)layoutForLocation:(CGFloat)xLocation
 {
-    // layout utilityContentView now
-    [_utilityContentView layoutForLocation:xLocation];
-
+    SWSignpostBegin("LayoutForLocation");
+    
     // compute offset damper
     CGFloat maxLocation = xLocation<0 ? -[_utilityContentView rightRevealWidth] : [_utilityContentView leftRevealWidth];
     if ( abs(xLocation) > abs(maxLocation) )
     {
-        CGFloat damperWidth = xLocation<0 ? -80 : 80;
+        CGFloat damperWidth = xLocation<0 ? -_overdrawDamperWidth : _overdrawDamperWidth;
         CGFloat overdraw = xLocation-maxLocation;
         xLocation = maxLocation + (overdraw*damperWidth)/(overdraw+damperWidth) ;
         xLocation = 0.5*round(2*xLocation);  // round to nearest halph point, good for retina
     }
     
+    // layout utilityContentView now, items are laid out for the damped location so they match the revealed area
+    [_utilityContentView layoutForLocation:xLocation];
+    
 //    // before setting our custom layout we call super layoutSubviews to get cell subview frames to the system values
 //    [super layoutSubviews];
     
     // now we update frames according to our required offset
     [self _setRevealLocation:xLocation];
+    
+    SWSignpostEnd("LayoutForLocation");
 }
 
 
@@ -1151,8 +3985,9 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 
 - (BOOL)gestureRecognizerShouldBegin:(UIGestureRecognizer *)recognizer
 {
-    // only allow gesture if no previous programmatic request is in process
-    if ( _animationQueue.count == 0 )
+    // only allow gesture if no previous programmatic request is in process, or if it is
+    // animating, in which case the animation will be interrupted when the gesture begins
+    if ( _requestQueue.count == 0 || _revealAnimationCompletion != nil )
     {
         if ( recognizer == _panGestureRecognizer )
             return [self _panGestureShouldBegin];
@@ -1162,11 +3997,21 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 }
 
 
+- (BOOL)gestureRecognizer:(UIGestureRecognizer *)gestureRecognizer shouldReceiveTouch:(UITouch *)touch
+{
+    // while the coordinator table view scrolls, new touches are not even tracked by the pan gesture
+    if ( gestureRecognizer == _panGestureRecognizer )
+        return ![_coordinator _suspendsRevealGestures];
+    
+    return YES;
+}
+
+
 - (BOOL)gestureRecognizer:(UIGestureRecognizer *)gestureRecognizer shouldRecognizeSimultaneouslyWithGestureRecognizer:(UIGestureRecognizer *)otherGestureRecognizer
 {
     if ( gestureRecognizer == _panGestureRecognizer )
     {
-        if ( [_delegate respondsToSelector:@selector(revealTableViewCell:panGestureRecognizerShouldRecognizeSimultaneouslyWithGestureRecognizer:)] )
+        if ( _delegateFlags.panGestureShouldRecognizeSimultaneously )
             if ( [_delegate revealTableViewCell:self panGestureRecognizerShouldRecognizeSimultaneouslyWithGestureRecognizer:otherGestureRecognizer] == YES )
                 return YES;
     }
@@ -1189,7 +4034,7 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 //        return NO;
     
     // forbid gesture if the following delegate is implemented and returns NO
-    if ( [_delegate respondsToSelector:@selector(revealTableViewCellPanGestureShouldBegin:)] )
+    if ( _delegateFlags.panGestureShouldBegin )
         if ( [_delegate revealTableViewCellPanGestureShouldBegin:self] == NO )
             return NO;
 
@@ -1198,8 +4043,8 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     
     BOOL draggableBorderAllowing = (
          _frontViewPosition != SWCellRevealPositionCenter || _draggableBorderWidth == 0.0f ||
-         (xLocation <= _draggableBorderWidth && _utilityContentView.leftCount>0) ||
-         (xLocation >= (width - _draggableBorderWidth) && _utilityContentView.rightCount>0) );
+         (xLocation <= _draggableBorderWidth && [self _hasLeftButtonItems]) ||
+         (xLocation >= (width - _draggableBorderWidth) && [self _hasRightButtonItems]) );
     
     // allow gesture only within the bounds defined by the draggableBorderWidth property
     return draggableBorderAllowing ;
@@ -1213,20 +4058,28 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     switch ( recognizer.state )
     {
         case UIGestureRecognizerStateBegan:
+            SWSignpostBegin("PanBegan");
             [self _handleRevealGestureStateBeganWithRecognizer:recognizer];
+            SWSignpostEnd("PanBegan");
             break;
             
         case UIGestureRecognizerStateChanged:
+            SWSignpostBegin("PanChanged");
             [self _handleRevealGestureStateChangedWithRecognizer:recognizer];
+            SWSignpostEnd("PanChanged");
             break;
             
         case UIGestureRecognizerStateEnded:
+            SWSignpostBegin("PanEnded");
             [self _handleRevealGestureStateEndedWithRecognizer:recognizer];
+            SWSignpostEnd("PanEnded");
             break;
             
         case UIGestureRecognizerStateCancelled:
         //case UIGestureRecognizerStateFailed:
+            SWSignpostBegin("PanCancelled");
             [self _handleRevealGestureStateCancelledWithRecognizer:recognizer];
+            SWSignpostEnd("PanCancelled");
             break;
             
         default:
@@ -1237,14 +4090,44 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 
 - (void)_handleRevealGestureStateBeganWithRecognizer:(UIPanGestureRecognizer *)recognizer
 {
-    // we know that we will not get here unless the animationQueue is empty because the recognizer
-    // delegate prevents it, however we do not want any forthcoming programatic actions to disturb
-    // the gesture, so we just enqueue a dummy block to ensure any simultaneous programatic actions will be
-    // scheduled after the gesture is completed
-    [self _enqueueBlock:^{}]; // <-- dummy block
+    // if we are animating we stop right where we are, the gesture will continue from there
+    CGFloat xLocation = 0;
+    BOOL interrupted = [self _interruptRevealAnimationAtLocation:&xLocation];
+    
+    // start measuring, only if someone is listening
+    if ( _metricsDelegate )
+    {
+        _gestureMetrics = [[SWRevealGestureMetrics alloc] init];
+        _gestureMetrics.beganTime = CACurrentMediaTime();
+    }
+    
+    // we know that we will not get here unless the request queue is empty or we interrupted an animation because the
+    // recognizer delegate prevents it, however we do not want any forthcoming programatic actions to disturb
+    // the gesture, so we just enqueue a gesture request to ensure any simultaneous programatic actions will be
+    // scheduled after the gesture is completed. The interruption already put one at the head of the queue
+    if ( !interrupted )
+    {
+        SWRevealRequest request = { SWRevealRequestKindGesture, _frontViewPosition, NO };
+        [self _enqueueRequest:request];
+    }
+    
+    // let the coordinator close any other revealed cell
+    [_coordinator _revealTableViewCellPanGestureBegan:self];
 
-    // we store the initial position and initialize a target position
-    _panInitialFrontPosition = _frontViewPosition;
+    // we store the initial location
+    _panInitialLocation = interrupted ? xLocation : [_utilityContentView frontLocationForPosition:_frontViewPosition];
+    
+    // from now on deployed items show their snapshots, if requested
+    if ( _rasterizesButtonItemsDuringGesture )
+        [_utilityContentView setRasterizesItems:YES];
+    
+    // get views back in place for the interrupted location, they may have been undeployed by the animation completion
+    if ( interrupted )
+        [self _layoutForPanLocation:_panInitialLocation];
+    
+    // if requested, pan updates will be applied from a display link rather than on each touch event
+    if ( _coalescesPanGestureUpdates )
+        [self _startPanDisplayLink];
 
     // notify delegate
     [self _notifyPanGestureBegan];
@@ -1255,12 +4138,39 @@ const NSInteger SWCellRevealPositionNone = 0xff;
 {
     CGFloat translation = [recognizer translationInView:self].x;
     
-    CGFloat baseLocation = [_utilityContentView frontLocationForPosition:_panInitialFrontPosition];
-    CGFloat xLocation = baseLocation + translation;
+    // when coalescing we just record the latest translation, the display link will apply it on the next frame
+    if ( _panDisplayLink )
+    {
+        _panTranslation = translation;
+        _panUpdatePending = YES;
+        [_panDisplayLink setPaused:NO];
+        return;
+    }
+    
+    [self _panGestureMovedToTranslation:translation];
+}
+
+
+- (void)_panGestureMovedToTranslation:(CGFloat)translation
+{
+    CFTimeInterval startTime = _gestureMetrics ? CACurrentMediaTime() : 0;
+    
+    [self _layoutForPanLocation:_panInitialLocation + translation];
+    [self _notifyPanGestureMoved];
     
+    if ( _gestureMetrics )
+    {
+        _gestureMetrics.frameCount += 1;
+        _gestureMetrics.worstFrameDuration = MAX(_gestureMetrics.worstFrameDuration, CACurrentMediaTime()-startTime);
+    }
+}
+
+
+- (void)_layoutForPanLocation:(CGFloat)xLocation
+{
     if ( xLocation < 0 )
     {
-        if ( _utilityContentView.rightCount == 0 ) xLocation = 0;
+        if ( ![self _hasRightButtonItems] ) xLocation = 0;
         //[self _frontDeploymentForNewRevealPosition:SWCellRevealPositionLeft]();
         [self _leftDeploymentForNewRevealPosition:SWCellRevealPositionLeft]();
         [self _rightDeploymentForNewRevealPosition:SWCellRevealPositionLeft]();
@@ -1268,19 +4178,21 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     
     if ( xLocation > 0 )
     {
-        if ( _utilityContentView.leftCount == 0 ) xLocation = 0;
+        if ( ![self _hasLeftButtonItems] ) xLocation = 0;
         //[self _frontDeploymentForNewRevealPosition:SWCellRevealPositionRight]();
         [self _rightDeploymentForNewRevealPosition:SWCellRevealPositionRight]();
         [self _leftDeploymentForNewRevealPosition:SWCellRevealPositionRight]();
     }
     
     [self layoutForLocation:xLocation];
-    [self _notifyPanGestureMoved];
 }
 
 
 - (void)_handleRevealGestureStateEndedWithRecognizer:(UIPanGestureRecognizer *)recognizer
 {
+    // apply any pending translation, so we compute the final position from the actual finger location
+    [self _flushPanDisplayLink];
+    
     CGFloat xLocation = _revealLocation;
     CGFloat velocity = [recognizer velocityInView:self].x;
     //NSLog( @"Velocity:%1.4f", velocity);
@@ -1339,18 +4251,90 @@ const NSInteger SWCellRevealPositionNone = 0xff;
     // symetric replacement of frontViewPosition
     [self _getAdjustedRevealPosition:&revealPosition forSymmetry:symmetry];
     
+    // the animation starts with the finger velocity, spring velocities are relative to the journey
+    CGFloat journey = [_utilityContentView frontLocationForPosition:revealPosition] - _revealLocation;
+    CGFloat springVelocity = fabs(journey) >= 1.0f ? velocity/journey : 1/duration;
+    
     // Animate to the final position
     [self _notifyPanGestureEnded];
-    [self _setRevealPosition:revealPosition withDuration:duration];
+    [self _reportGestureMetrics];
+    [self _setRevealPosition:revealPosition withDuration:duration initialSpringVelocity:springVelocity];
 }
 
 
 - (void)_handleRevealGestureStateCancelledWithRecognizer:(UIPanGestureRecognizer *)recognizer
 {
+    [self _flushPanDisplayLink];
+    [_utilityContentView setRasterizesItems:NO];
     [self _notifyPanGestureEnded];
+    [self _reportGestureMetrics];
     [self _dequeue];
 }
 
+
+#pragma mark - Gesture metrics
+
+- (void)_reportGestureMetrics
+{
+    SWRevealGestureMetrics *metrics = _gestureMetrics;
+    _gestureMetrics = nil;
+    
+    if ( metrics == nil )
+        return;
+    
+    metrics.duration = CACurrentMediaTime() - metrics.beganTime;
+    [_metricsDelegate revealTableViewCell:self didEndPanGestureWithMetrics:metrics];
+}
+
+
+#pragma mark - Pan display link
+
+// The display link retains its target, so we only keep it alive for the duration of a gesture
+- (void)_startPanDisplayLink
+{
+    [self _invalidatePanDisplayLink];
+    
+    _panDisplayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(_panDisplayLinkFired:)];
+    [_panDisplayLink setPaused:YES];
+    [_panDisplayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+}
+
+
+- (void)_panDisplayLinkFired:(CADisplayLink*)displayLink
+{
+    // nothing more to do until the next touch event
+    [displayLink setPaused:YES];
+    
+    if ( _panUpdatePending )
+    {
+        _panUpdatePending = NO;
+        [self _panGestureMovedToTranslation:_panTranslation];
+    }
+}
+
+
+- (void)_flushPanDisplayLink
+{
+    if ( _panDisplayLink == nil )
+        return;
+    
+    if ( _panUpdatePending )
+    {
+        _panUpdatePending = NO;
+        [self _panGestureMovedToTranslation:_panTranslation];
+    }
+    
+    [self _invalidatePanDisplayLink];
+}
+
+
+- (void)_invalidatePanDisplayLink
+{
+    [_panDisplayLink invalidate];
+    _panDisplayLink = nil;
+    _panUpdatePending = NO;
+}
+
 @end
 
 